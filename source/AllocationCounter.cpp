@@ -0,0 +1,104 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "AllocationCounter.h"
+
+// Kept out of line in their own translation unit: were the replacements
+// inlined next to their callers, GCC would pair the malloc behind operator new
+// with the free behind operator delete and warn about mismatched new/delete.
+
+static std::atomic<uint64_t> g_Allocations { 0 };
+
+uint64_t AllocationCounter::Get()
+{
+    return g_Allocations.load(std::memory_order_relaxed);
+}
+
+static void* Allocate(size_t size) noexcept
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+static void* AllocateAligned(size_t size, std::align_val_t alignment) noexcept
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = size_t(alignment);
+    // aligned_alloc wants a whole number of alignments
+    size = (size + align - 1) / align * align;
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : align, align);
+#else
+    return std::aligned_alloc(align, size ? size : align);
+#endif
+}
+
+static void FreeAligned(void* p) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(size_t size)
+{
+    if (void* p = Allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (void* p = Allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* p = AllocateAligned(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    if (void* p = AllocateAligned(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+// Counts heap allocations made through the global operator new, in every form
+// (scalar, array, aligned, nothrow). The counting operators live in
+// AllocationCounter.cpp, which only the bench and headless executables compile
+// in, so laser_core keeps the standard ones.
+class AllocationCounter
+{
+public:
+    static uint64_t Get();
+};
@@ -0,0 +1,869 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "AllocationCounter.h"
+#include "DistortionCorrector.h"
+#include "EventManager.h"
+#include "FrameBuffer.h"
+#include "GalvoSimulator.h"
+#include "Idn.h"
+#include "LaserColor.h"
+#include "LaserFrameGenerator.h"
+#include "Matrix3X3.h"
+#include "Point2D.h"
+#include "Shapes.h"
+#include "SpscQueue.h"
+#include "SoftwareRenderer.h"
+#include "ThreadPool.h"
+
+// Microbenchmarks for the frame generator and galvo simulator. Every case
+// runs its body in growing batches until --min-time has passed and reports
+// time per iteration, items per second and its own counters. --json writes
+// the results in Google Benchmark's JSON layout so runs from two commits can
+// be compared with the usual tools. Inputs come from a fixed seed.
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr float PI = 3.14159265358979323846f;
+static constexpr float PI2 = 2.0f * PI;
+static constexpr float MAX_ANGLE = 35.0f;
+
+// Results are folded in here so the optimizer cannot drop the work
+static volatile uint32_t g_Sink = 0;
+
+struct Options
+{
+    double minTime = 0.25;
+    uint32_t seed = 1234;
+    std::string filter;
+    std::string jsonPath;
+    bool list = false;
+};
+
+struct Result
+{
+    std::string name;
+    uint64_t iterations = 0;
+    double realNs = 0.0; // per iteration
+    double cpuNs = 0.0;
+    double itemsPerSecond = 0.0;
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+// Handed to each case: times the body and collects counters
+class Runner
+{
+public:
+    Runner(Result& result, double minTime) : m_Result(result), m_MinTime(minTime) {}
+    // body() runs one iteration and returns the items it processed
+    template <typename Body>
+    void Run(Body body)
+    {
+        // One untimed pass so buffers and tables reach their steady state
+        body();
+        uint64_t iterations = 1;
+        for (;;)
+        {
+            uint64_t items = 0;
+            std::clock_t c0 = std::clock();
+            auto t0 = Clock::now();
+            for (uint64_t i = 0; i < iterations; i++)
+                items += uint64_t(body());
+            double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+            double cpuSeconds = double(std::clock() - c0) / CLOCKS_PER_SEC;
+            if (seconds >= m_MinTime || iterations >= (uint64_t(1) << 40))
+            {
+                m_Result.iterations = iterations;
+                m_Result.realNs = seconds * 1e9 / double(iterations);
+                m_Result.cpuNs = cpuSeconds * 1e9 / double(iterations);
+                m_Result.itemsPerSecond = double(items) / seconds;
+                return;
+            }
+            // Aim a little past the minimum time, growing at most tenfold per round
+            double scale = (seconds > 0.0) ? std::min(10.0, std::max(2.0, 1.4 * m_MinTime / seconds)) : 10.0;
+            iterations = uint64_t(double(iterations) * scale);
+        }
+    }
+    void Counter(const char* name, double value) { m_Result.counters.emplace_back(name, value); }
+private:
+    Result& m_Result;
+    double m_MinTime;
+};
+
+struct Case
+{
+    std::string name;
+    std::function<void(Runner&)> run;
+};
+
+// The headless driver's scene: the ship, a ring of bullets, the arc test and a linkage
+struct SceneFixture
+{
+    LaserFrameGenerator generator;
+    ShapeGenerator shapes;
+    Linkage linkage;
+    SceneFixture() :
+        generator(0.9f, MAX_ANGLE),
+        shapes(generator),
+        linkage(generator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f)
+    {
+    }
+    const LaserFrame& Draw(int frame, int bullets = 256)
+    {
+        float time = float(frame) / 60.0f;
+        LaserColor white(0.0f, 0.0f, 1.0f);
+        LaserColor redgreen(LaserColor::RGB8 { 255, 0, 0 }, LaserColor::RGB8 { 0, 255, 0 });
+        generator.NewFrame();
+        shapes.Ship(Mat3::Rotation(time), white);
+        for (int i = 0; i < bullets; i++)
+        {
+            float a = PI2 * float(i) / float(bullets) + time * 0.5f;
+            float r = 0.3f + 0.5f * float(i % 8) / 8.0f;
+            Mat3 matrix = Mat3::Translation(std::cos(a) * r, std::sin(a) * r) * Mat3::Rotation(a) * Mat3::Scale(0.01f, 0.01f);
+            shapes.Square(matrix, redgreen);
+        }
+        shapes.ArcTest(Point2D(-0.6f, 0.6f), 0.3f, redgreen);
+        float angle = std::fmod(time * 2.0f, PI2) - PI2;
+        linkage.DrawLinkage(Mat3::Translation(0.5f, -0.5f) * Mat3::Scale(0.1f, 0.1f), angle, white);
+        generator.EndFrame();
+        return generator.GetLaserFrame();
+    }
+};
+
+static std::vector<Point2D> RandomPoints(std::mt19937& random, int count, float extent)
+{
+    std::uniform_real_distribution<float> coordinate(-extent, extent);
+    std::vector<Point2D> points(count);
+    for (Point2D& p : points)
+    {
+        p.x = coordinate(random);
+        p.y = coordinate(random);
+    }
+    return points;
+}
+
+static float SegmentDistance(Point2D p, Point2D a, Point2D b)
+{
+    Point2D ab = b - a;
+    float lengthSq = ab.x * ab.x + ab.y * ab.y;
+    float u = (lengthSq > 0.0f) ? std::clamp(((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / lengthSq, 0.0f, 1.0f) : 0.0f;
+    return (p - (a + ab * u)).Length();
+}
+
+struct TrajectoryError
+{
+    double maxError = 0.0;
+    double meanError = 0.0;
+};
+
+// Distance from every point of path to the reference trajectory. Both visit
+// the frame's targets in order, so the nearest reference segment is looked
+// for in a window ahead of the last match rather than over the whole path.
+static TrajectoryError CompareTrajectories(const SimFrame& reference, const SimFrame& path)
+{
+    TrajectoryError error;
+    if (reference.size() < 2 || path.empty())
+        return error;
+    const size_t last = reference.size() - 1;
+    const size_t window = 256 + 8 * (reference.size() / path.size());
+    size_t cursor = 0;
+    double sum = 0.0;
+    for (const SimPoint& point : path)
+    {
+        Point2D p(point.x, point.y);
+        size_t begin = (cursor > 64) ? cursor - 64 : 0;
+        size_t end = std::min(last, cursor + window);
+        float best = SegmentDistance(p, Point2D(reference[begin].x, reference[begin].y), Point2D(reference[begin + 1].x, reference[begin + 1].y));
+        size_t bestIndex = begin;
+        for (size_t i = begin + 1; i < end; i++)
+        {
+            float d = SegmentDistance(p, Point2D(reference[i].x, reference[i].y), Point2D(reference[i + 1].x, reference[i + 1].y));
+            if (d < best)
+            {
+                best = d;
+                bestIndex = i;
+            }
+        }
+        cursor = bestIndex;
+        error.maxError = std::max(error.maxError, double(best));
+        sum += best;
+    }
+    error.meanError = sum / double(path.size());
+    return error;
+}
+
+static void AddGeneratorCases(std::vector<Case>& cases, const Options& options)
+{
+    using LS = LaserFrameGenerator::LaserState;
+    using PS = LaserFrameGenerator::PointSharpness;
+    LaserColor redgreen(LaserColor::RGB8 { 255, 0, 0 }, LaserColor::RGB8 { 0, 255, 0 });
+
+    for (PS sharpness : { PS::SHARP, PS::SMOOTH })
+    {
+        // 64 random segments per frame
+        cases.push_back({ std::string("LineTo/") + (sharpness == PS::SHARP ? "SHARP" : "SMOOTH"), [=] (Runner& runner)
+        {
+            std::mt19937 random(options.seed);
+            std::vector<Point2D> points = RandomPoints(random, 64, 0.9f);
+            LaserFrameGenerator generator(0.9f, MAX_ANGLE);
+            runner.Run([&] ()
+            {
+                generator.NewFrame();
+                for (size_t i = 0; i < points.size(); i++)
+                    generator.LineTo(points[i], (i % 4 == 0) ? LS::OFF : LS::ON, sharpness, redgreen);
+                g_Sink = g_Sink + generator.GetLaserFrame().back().x;
+                return generator.GetLaserFrame().size();
+            });
+        } });
+    }
+
+    // 32 random arcs per frame, alternating direction
+    cases.push_back({ "ArcTo", [=] (Runner& runner)
+    {
+        std::mt19937 random(options.seed);
+        std::vector<Point2D> centers = RandomPoints(random, 32, 0.5f);
+        std::vector<Point2D> ends = RandomPoints(random, 32, 0.3f);
+        LaserFrameGenerator generator(0.9f, MAX_ANGLE);
+        runner.Run([&] ()
+        {
+            generator.NewFrame();
+            for (size_t i = 0; i < centers.size(); i++)
+            {
+                auto direction = (i % 2) ? LaserFrameGenerator::Arc::CLOCKWISE : LaserFrameGenerator::Arc::COUNTERCLOCKWISE;
+                generator.ArcTo(centers[i], centers[i] + ends[i], LS::ON, PS::SMOOTH, redgreen, direction);
+            }
+            g_Sink = g_Sink + generator.GetLaserFrame().back().x;
+            return generator.GetLaserFrame().size();
+        });
+    } });
+
+    // A 256-point polyline drawn whole and half way
+    cases.push_back({ "DrawShape", [=] (Runner& runner)
+    {
+        std::vector<Point2D> points(256);
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            float a = PI2 * float(i) / float(points.size());
+            float r = 0.5f + 0.2f * std::sin(a * 5.0f);
+            points[i] = Point2D(std::cos(a) * r, std::sin(a) * r);
+        }
+        LaserFrameGenerator generator(0.9f, MAX_ANGLE);
+        runner.Run([&] ()
+        {
+            generator.NewFrame();
+            generator.DrawShape(points, 1.0f, redgreen);
+            generator.DrawShape(points, 0.5f, redgreen);
+            g_Sink = g_Sink + generator.GetLaserFrame().back().x;
+            return generator.GetLaserFrame().size();
+        });
+    } });
+
+    // Whole scene frames: correction mode and exact vs baked color
+    struct SceneMode
+    {
+        const char* name;
+        DistortionCorrector::Mode correction;
+        bool colorTables;
+        bool templates;
+    };
+    for (SceneMode mode : { SceneMode { "EXACT", DistortionCorrector::Mode::EXACT, true, true },
+                            SceneMode { "LUT", DistortionCorrector::Mode::LUT, true, true },
+                            SceneMode { "EXACT_HSV", DistortionCorrector::Mode::EXACT, false, true },
+                            SceneMode { "EXACT_NO_TEMPLATES", DistortionCorrector::Mode::EXACT, true, false } })
+    {
+        cases.push_back({ std::string("Scene/Generate/") + mode.name, [=] (Runner& runner)
+        {
+            SceneFixture scene;
+            scene.generator.SetCorrectionMode(mode.correction);
+            scene.generator.SetColorTables(mode.colorTables);
+            scene.shapes.SetShapeTemplates(mode.templates);
+            int frame = 0;
+            runner.Run([&] () { return scene.Draw(frame++ % 600).size(); });
+            runner.Counter("points_per_frame", double(scene.generator.GetLaserFrame().size()));
+        } });
+    }
+
+    // Bullets in many gradient colors, interleaved the way per-entity pool colors are:
+    // 16 fit the color cache, 48 cycle through more than it holds
+    for (int colorCount : { 16, 48 })
+    {
+        for (bool colorTables : { true, false })
+        {
+            std::string name = "Scene/ManyColors/" + std::to_string(colorCount) + (colorTables ? "/TABLES" : "/EXACT_HSV");
+            cases.push_back({ name, [=] (Runner& runner)
+            {
+                SceneFixture scene;
+                scene.generator.SetColorTables(colorTables);
+                std::vector<LaserColor> colors;
+                for (int i = 0; i < colorCount; i++)
+                    colors.push_back(LaserColor(360.0f * float(i) / float(colorCount), 360.0f * float(i) / float(colorCount) + 90.0f, 1.0f, 1.0f, 1.0f, 0.5f));
+                int frame = 0;
+                runner.Run([&] ()
+                {
+                    float time = float(frame++ % 600) / 60.0f;
+                    scene.generator.NewFrame();
+                    for (int i = 0; i < 256; i++)
+                    {
+                        float a = PI2 * float(i) / 256.0f + time * 0.5f;
+                        float r = 0.3f + 0.5f * float(i % 8) / 8.0f;
+                        Mat3 matrix = Mat3::Translation(std::cos(a) * r, std::sin(a) * r) * Mat3::Rotation(a) * Mat3::Scale(0.01f, 0.01f);
+                        scene.shapes.Square(matrix, colors[i % colors.size()]);
+                    }
+                    scene.generator.EndFrame();
+                    return scene.generator.GetLaserFrame().size();
+                });
+            } });
+        }
+    }
+
+    cases.push_back({ "Linkage/Construct", [] (Runner& runner)
+    {
+        LaserFrameGenerator generator(0.9f, MAX_ANGLE);
+        runner.Run([&] ()
+        {
+            Linkage linkage(generator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+            return 1;
+        });
+    } });
+
+    cases.push_back({ "Linkage/Draw", [] (Runner& runner)
+    {
+        LaserFrameGenerator generator(0.9f, MAX_ANGLE);
+        Linkage linkage(generator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+        LaserColor white(0.0f, 0.0f, 1.0f);
+        Mat3 matrix = Mat3::Translation(0.5f, -0.5f) * Mat3::Scale(0.1f, 0.1f);
+        int frame = 0;
+        runner.Run([&] ()
+        {
+            generator.NewFrame();
+            linkage.DrawLinkage(matrix, PI2 * float(frame++ % 360) / 360.0f - PI2, white);
+            return generator.GetLaserFrame().size();
+        });
+    } });
+    // 16 linkages in one DrawLinkages call, spread over the screen at staggered angles
+    cases.push_back({ "Linkage/DrawBatch/16", [] (Runner& runner)
+    {
+        LaserFrameGenerator generator(0.9f, MAX_ANGLE);
+        Linkage linkage(generator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+        LaserColor white(0.0f, 0.0f, 1.0f);
+        std::vector<Mat3> matrices(16);
+        std::vector<float> angles(16);
+        for (int i = 0; i < 16; i++)
+            matrices[i] = Mat3::Translation(-0.6f + 0.4f * float(i % 4), -0.6f + 0.4f * float(i / 4)) * Mat3::Scale(0.03f, 0.03f);
+        int frame = 0;
+        runner.Run([&] ()
+        {
+            for (int i = 0; i < 16; i++)
+                angles[i] = PI2 * float((frame + i * 23) % 360) / 360.0f - PI2;
+            frame++;
+            generator.NewFrame();
+            linkage.DrawLinkages(matrices.data(), angles.data(), 16, white);
+            return generator.GetLaserFrame().size();
+        });
+    } });
+}
+
+static void AddMathCases(std::vector<Case>& cases, const Options& options)
+{
+    for (DistortionCorrector::Mode mode : { DistortionCorrector::Mode::EXACT, DistortionCorrector::Mode::LUT })
+    {
+        const char* name = (mode == DistortionCorrector::Mode::EXACT) ? "EXACT" : "LUT";
+        cases.push_back({ std::string("DistortionCorrection/") + name, [=] (Runner& runner)
+        {
+            std::mt19937 random(options.seed);
+            std::vector<Point2D> points = RandomPoints(random, 4096, 1.0f);
+            DistortionCorrector corrector(MAX_ANGLE);
+            corrector.SetMode(mode);
+            runner.Run([&] ()
+            {
+                float sum = 0.0f;
+                for (Point2D p : points)
+                {
+                    corrector.Apply(p);
+                    sum += p.x + p.y;
+                }
+                g_Sink = g_Sink + uint32_t(sum);
+                return points.size();
+            });
+        } });
+    }
+
+    struct ColorCase
+    {
+        const char* name;
+        LaserColor color;
+    };
+    for (ColorCase c : { ColorCase { "Solid", LaserColor(0.0f, 0.0f, 1.0f) },
+                         ColorCase { "Gradient", LaserColor(LaserColor::RGB8 { 255, 0, 0 }, LaserColor::RGB8 { 0, 255, 0 }) },
+                         ColorCase { "HueWheel", LaserColor(0.0f, 359.0f, 1.0f, 1.0f, 1.0f, 1.0f) } })
+    {
+        cases.push_back({ std::string("LaserColor/getRGB/") + c.name, [=] (Runner& runner)
+        {
+            runner.Run([&] ()
+            {
+                uint32_t sum = 0;
+                for (int i = 0; i < 4096; i++)
+                {
+                    LaserColor::RGB8 rgb = c.color.getRGB(float(i) / 4095.0f);
+                    sum += rgb.r + rgb.g + rgb.b;
+                }
+                g_Sink = g_Sink + sum;
+                return 4096;
+            });
+        } });
+        // A solid table is a single entry, nothing to time
+        if (c.color.IsSolid())
+            continue;
+        cases.push_back({ std::string("LaserColorTable/Lookup/") + c.name, [=] (Runner& runner)
+        {
+            LaserColorTable table(c.color);
+            runner.Run([&] ()
+            {
+                uint32_t sum = 0;
+                for (int i = 0; i < 4096; i++)
+                {
+                    LaserColor::RGB8 rgb = table.Lookup(float(i) / 4095.0f);
+                    sum += rgb.r + rgb.g + rgb.b;
+                }
+                g_Sink = g_Sink + sum;
+                return 4096;
+            });
+            runner.Counter("max_error", double(table.MeasureError().maxError));
+        } });
+    }
+
+    // Products of random translate/rotate/scale matrices, as the pools build them
+    cases.push_back({ "Mat3/Multiply", [=] (Runner& runner)
+    {
+        std::mt19937 random(options.seed);
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+        std::vector<Mat3> matrices(256);
+        for (Mat3& m : matrices)
+            m = Mat3::Translation(value(random), value(random)) * Mat3::Rotation(value(random) * PI) * Mat3::Scale(0.01f, 0.01f);
+        std::vector<Mat3> products(matrices.size());
+        runner.Run([&] ()
+        {
+            for (size_t i = 0; i + 1 < matrices.size(); i++)
+                products[i] = matrices[i] * matrices[i + 1];
+            g_Sink = g_Sink + uint32_t(products[g_Sink % 255].m[0][2] * 1000.0f);
+            return matrices.size() - 1;
+        });
+    } });
+
+    cases.push_back({ "Mat3/TransformPoint", [=] (Runner& runner)
+    {
+        std::mt19937 random(options.seed);
+        std::vector<Point2D> points = RandomPoints(random, 4096, 1.0f);
+        Mat3 matrix = Mat3::Translation(0.2f, -0.1f) * Mat3::Rotation(0.7f) * Mat3::Scale(0.5f, 0.5f);
+        runner.Run([&] ()
+        {
+            float sum = 0.0f;
+            for (const Point2D& p : points)
+            {
+                Point2D q = matrix.transformPoint(p);
+                sum += q.x + q.y;
+            }
+            g_Sink = g_Sink + uint32_t(sum);
+            return points.size();
+        });
+    } });
+}
+
+static void AddSimulatorCases(std::vector<Case>& cases)
+{
+    // Integrator and steps per frame (dt = 1/steps); Euler at 500 is the reference model
+    struct SimCase
+    {
+        GalvoSimulator::Integrator integrator;
+        int steps;
+    };
+    for (SimCase c : { SimCase { GalvoSimulator::Integrator::EULER, 500 },
+                       SimCase { GalvoSimulator::Integrator::EXACT, 500 },
+                       SimCase { GalvoSimulator::Integrator::EXACT, 250 },
+                       SimCase { GalvoSimulator::Integrator::EXACT, 100 },
+                       SimCase { GalvoSimulator::Integrator::FIXED, 500 } })
+    {
+        const char* integrator = (c.integrator == GalvoSimulator::Integrator::EULER) ? "EULER" :
+            (c.integrator == GalvoSimulator::Integrator::EXACT) ? "EXACT" : "FIXED";
+        cases.push_back({ std::string("Simulate/") + integrator + "/" + std::to_string(c.steps), [=] (Runner& runner)
+        {
+            SceneFixture scene;
+            const LaserFrame& frame = scene.Draw(0);
+            GalvoSimulator reference(MAX_ANGLE);
+            reference.Simulate(frame, 1.0f / 500.0f);
+            GalvoSimulator simulator(MAX_ANGLE);
+            simulator.SetIntegrator(c.integrator);
+            float dt = 1.0f / float(c.steps);
+            runner.Run([&] ()
+            {
+                simulator.Simulate(frame, dt);
+                return simulator.GetSimFrame().size();
+            });
+            // Simulate restarts from the galvo's last position, so compare fresh simulators
+            GalvoSimulator fresh(MAX_ANGLE);
+            fresh.SetIntegrator(c.integrator);
+            fresh.Simulate(frame, dt);
+            TrajectoryError error = CompareTrajectories(reference.GetSimFrame(), fresh.GetSimFrame());
+            const SimPoint& end = fresh.GetSimFrame().back();
+            const SimPoint& referenceEnd = reference.GetSimFrame().back();
+            runner.Counter("laser_points", double(frame.size()));
+            runner.Counter("sim_steps", double(fresh.GetSimFrame().size()));
+            runner.Counter("max_error", error.maxError);
+            runner.Counter("mean_error", error.meanError);
+            runner.Counter("end_error", double(Point2D(end.x - referenceEnd.x, end.y - referenceEnd.y).Length()));
+            // FNV-1a of the trajectory's bits, cut to six digits so it prints whole; FIXED must match on every platform
+            uint32_t hash = 2166136261u;
+            for (const SimPoint& p : fresh.GetSimFrame())
+            {
+                uint32_t words[2];
+                std::memcpy(words, &p.x, sizeof(float));
+                std::memcpy(words + 1, &p.y, sizeof(float));
+                for (uint32_t word : words)
+                    hash = (hash ^ word) * 16777619u;
+            }
+            runner.Counter("sim_hash", double(hash % 1000000));
+        } });
+    }
+
+    // Heap allocations per steady-state frame, generation plus simulation
+    for (bool arena : { false, true })
+    {
+        cases.push_back({ std::string("Frame/Allocations/") + (arena ? "Arena" : "Heap"), [=] (Runner& runner)
+        {
+            // Arenas first: they must outlive the buffers placed in them
+            FrameArena laserArena(4 << 20);
+            FrameArena simArena(8 << 20);
+            SceneFixture scene;
+            GalvoSimulator simulator(MAX_ANGLE);
+            if (arena)
+            {
+                scene.generator.SetFrameMemory(&laserArena);
+                simulator.SetFrameMemory(&simArena);
+            }
+            int frame = 0;
+            uint64_t before = 0;
+            bool started = false;
+            runner.Run([&] ()
+            {
+                // The first call is the untimed warm-up; count from the next one on
+                if (!started && frame == 1)
+                {
+                    started = true;
+                    before = AllocationCounter::Get();
+                }
+                const LaserFrame& laserFrame = scene.Draw(frame++ % 600);
+                simulator.Simulate(laserFrame, 1.0f / 500.0f);
+                return 1;
+            });
+            uint64_t allocations = AllocationCounter::Get() - before;
+            runner.Counter("allocs_per_frame", double(allocations) / double(frame - 1));
+            runner.Counter("laser_reallocations", double(scene.generator.GetFramePolicy().GetStats().reallocations));
+            runner.Counter("sim_reallocations", double(simulator.GetFramePolicy().GetStats().reallocations));
+            if (arena)
+                runner.Counter("arena_heap_fallbacks", double(laserArena.GetHeapAllocations() + simArena.GetHeapAllocations()));
+        } });
+    }
+}
+
+// CPU rasterizer at 1080p: the simulated scene, and a 100k-segment Lissajous
+// figure (the target load), serial and across the pool
+static void AddRenderCases(std::vector<Case>& cases)
+{
+    for (bool lissajous : { false, true })
+    {
+        for (bool parallel : { false, true })
+        {
+            std::string name = std::string("Rasterize/") + (lissajous ? "Lissajous100k" : "Scene") + (parallel ? "/Pool" : "/Serial");
+            cases.push_back({ name, [=] (Runner& runner)
+            {
+                SimFrame frame;
+                if (lissajous)
+                {
+                    const int segments = 100000;
+                    frame.resize(segments + 1);
+                    for (int i = 0; i <= segments; i++)
+                    {
+                        float t = PI2 * float(i) / float(segments);
+                        frame[i] = { 0.9f * std::sin(3.0f * t), 0.9f * std::sin(4.0f * t + 0.5f),
+                            uint8_t(128 + 127 * std::sin(t)), 255, uint8_t(128 + 127 * std::cos(t)), 1 };
+                    }
+                }
+                else
+                {
+                    SceneFixture scene;
+                    GalvoSimulator simulator(MAX_ANGLE);
+                    simulator.Simulate(scene.Draw(0), 1.0f / 500.0f);
+                    frame = simulator.GetSimFrame();
+                }
+                ThreadPool pool;
+                SoftwareRenderer renderer(1920, 1080, parallel ? &pool : nullptr);
+                runner.Run([&] ()
+                {
+                    renderer.DrawFrame(frame, 1.0f / 60.0f);
+                    return renderer.GetStats().litSegments;
+                });
+                runner.Counter("threads", double(parallel ? pool.GetThreadCount() : 1));
+                runner.Counter("segments", double(frame.size() - 1));
+                runner.Counter("samples", double(renderer.GetStats().samples));
+            } });
+        }
+    }
+}
+
+// Output paths for a finished frame
+static void AddOutputCases(std::vector<Case>& cases)
+{
+    // The scene frame sent over loopback UDP as IDN and reassembled, unpaced, both ends on this thread
+    cases.push_back({ "Idn/Loopback", [] (Runner& runner)
+    {
+        SceneFixture scene;
+        const LaserFrame& frame = scene.Draw(0);
+        IdnReceiver receiver(0);
+        IdnSender sender("127.0.0.1", receiver.GetPort(), 30000.0f);
+        sender.SetPacing(false);
+        LaserFrame received;
+        runner.Run([&] ()
+        {
+            sender.SendFrame(frame);
+            return receiver.ReceiveFrame(received, 1000) ? received.size() : 0;
+        });
+        runner.Counter("points", double(frame.size()));
+        runner.Counter("packets_per_frame", double(sender.GetStats().packetsSent) / double(sender.GetStats().framesSent));
+        runner.Counter("frames_dropped", double(receiver.GetStats().framesDropped));
+        // Blanked points arrive black, and black points arrive blanked
+        size_t mismatches = received.size() == frame.size() ? 0 : frame.size();
+        for (size_t i = 0; i < received.size() && i < frame.size(); i++)
+        {
+            const LaserPoint& a = frame[i];
+            const LaserPoint& b = received[i];
+            bool lit = a.flags && (a.r | a.g | a.b);
+            bool same = a.x == b.x && a.y == b.y && b.flags == (lit ? 1 : 0) &&
+                (!lit || (a.r == b.r && a.g == b.g && a.b == b.b));
+            mismatches += same ? 0 : 1;
+        }
+        runner.Counter("mismatches", double(mismatches));
+    } });
+
+    // Queueing a frame for DAC playback and draining it, point by point vs one publish per batch
+    for (bool batched : { false, true })
+    {
+        cases.push_back({ std::string("DacRing/") + (batched ? "Batch" : "PerPoint"), [=] (Runner& runner)
+        {
+            SceneFixture scene;
+            const LaserFrame& frame = scene.Draw(0);
+            SpscQueue<LaserPoint> ring(1 << 16);
+            std::vector<LaserPoint> out(frame.size());
+            runner.Run([&] ()
+            {
+                size_t popped = 0;
+                if (batched)
+                {
+                    ring.TryPushMany(frame.data(), frame.size());
+                    popped = ring.TryPopMany(out.data(), out.size());
+                }
+                else
+                {
+                    for (const LaserPoint& point : frame)
+                        ring.TryPush(point);
+                    while (popped < out.size() && ring.TryPop(out[popped]))
+                        popped++;
+                }
+                return popped;
+            });
+        } });
+    }
+}
+
+// Per-frame gameplay events: every ship's actions fired, each heard by a couple of listeners
+static void AddEventCases(std::vector<Case>& cases)
+{
+    static constexpr int Ships = 64;
+    static constexpr const char* Actions[] = { "TurnLeft", "TurnRight", "Thrust", "Brake", "Fire" };
+    // String: emit by name, one hash per event. Interned: by ID. Queued: by ID through Queue and one Dispatch.
+    for (const char* mode : { "String", "Interned", "Queued" })
+    {
+        cases.push_back({ std::string("Events/") + mode, [=] (Runner& runner)
+        {
+            EventManager events;
+            std::vector<std::string> names;
+            std::vector<EventManager::EventId> ids;
+            size_t calls = 0;
+            for (int ship = 0; ship < Ships; ship++)
+            {
+                for (const char* action : Actions)
+                {
+                    names.push_back("Ship" + std::to_string(ship) + "/" + action);
+                    ids.push_back(events.Intern(names.back()));
+                    events.Subscribe(ids.back(), [&] () { calls++; });
+                    events.Subscribe(ids.back(), [&] () { calls += 2; });
+                }
+            }
+            std::string_view name(mode);
+            runner.Run([&] ()
+            {
+                if (name == "String")
+                {
+                    for (const std::string& event : names)
+                        events.Emit(event);
+                }
+                else if (name == "Interned")
+                {
+                    for (EventManager::EventId id : ids)
+                        events.Emit(id);
+                }
+                else
+                {
+                    for (EventManager::EventId id : ids)
+                        events.Queue(id);
+                    events.Dispatch();
+                }
+                return names.size();
+            });
+            runner.Counter("events", double(names.size()));
+            runner.Counter("listeners", double(2 * names.size()));
+        } });
+    }
+}
+
+static void WriteJsonString(FILE* file, std::string_view text)
+{
+    std::fputc('"', file);
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            std::fputc('\\', file);
+        std::fputc(c, file);
+    }
+    std::fputc('"', file);
+}
+
+static bool WriteJson(const std::string& path, const std::vector<Result>& results, const Options& options)
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    std::fprintf(file, "{\n  \"context\": {\n");
+    std::fprintf(file, "    \"date\": \"%s\",\n", date);
+    std::fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    std::fprintf(file, "    \"library_build_type\": \"release\",\n");
+#else
+    std::fprintf(file, "    \"library_build_type\": \"debug\",\n");
+#endif
+    std::fprintf(file, "    \"seed\": %u,\n    \"min_time\": %g\n  },\n  \"benchmarks\": [\n", options.seed, options.minTime);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        std::fprintf(file, "    {\n      \"name\": ");
+        WriteJsonString(file, r.name);
+        std::fprintf(file, ",\n      \"run_name\": ");
+        WriteJsonString(file, r.name);
+        std::fprintf(file, ",\n      \"run_type\": \"iteration\",\n      \"iterations\": %llu,\n", (unsigned long long)r.iterations);
+        std::fprintf(file, "      \"real_time\": %.6g,\n      \"cpu_time\": %.6g,\n      \"time_unit\": \"ns\",\n", r.realNs, r.cpuNs);
+        std::fprintf(file, "      \"items_per_second\": %.6g", r.itemsPerSecond);
+        for (const auto& [name, value] : r.counters)
+        {
+            std::fprintf(file, ",\n      ");
+            WriteJsonString(file, name);
+            std::fprintf(file, ": %.6g", value);
+        }
+        std::fprintf(file, "\n    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+static void PrintUsage()
+{
+    std::printf(
+        "usage: laser_bench [options]\n"
+        "  --filter TEXT  run only cases whose name contains TEXT\n"
+        "  --min-time S   minimum timed seconds per case (0.25)\n"
+        "  --seed N       seed for the random inputs (1234)\n"
+        "  --json FILE    also write the results as Google Benchmark style JSON\n"
+        "  --list         print the case names and exit\n");
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--min-time" && hasValue)
+            options.minTime = std::max(0.001, std::atof(argv[++i]));
+        else if (arg == "--seed" && hasValue)
+            options.seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--json" && hasValue)
+            options.jsonPath = argv[++i];
+        else if (arg == "--list")
+            options.list = true;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+    std::vector<Case> cases;
+    AddGeneratorCases(cases, options);
+    AddMathCases(cases, options);
+    AddSimulatorCases(cases);
+    AddRenderCases(cases);
+    AddOutputCases(cases);
+    AddEventCases(cases);
+
+    std::vector<Result> results;
+    if (!options.list)
+        std::printf("%-36s %14s %14s %12s %14s\n", "case", "time/iter", "cpu/iter", "iterations", "items/s");
+    for (const Case& c : cases)
+    {
+        if (c.name.find(options.filter) == std::string::npos)
+            continue;
+        if (options.list)
+        {
+            std::printf("%s\n", c.name.c_str());
+            continue;
+        }
+        Result result;
+        result.name = c.name;
+        Runner runner(result, options.minTime);
+        c.run(runner);
+        std::printf("%-36s %11.1f ns %11.1f ns %12llu %14.4g", result.name.c_str(), result.realNs, result.cpuNs,
+            (unsigned long long)result.iterations, result.itemsPerSecond);
+        for (const auto& [name, value] : result.counters)
+            std::printf(" %s=%g", name.c_str(), value);
+        std::printf("\n");
+        results.push_back(std::move(result));
+    }
+    if (!options.jsonPath.empty() && !WriteJson(options.jsonPath, results, options))
+    {
+        std::fprintf(stderr, "could not write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
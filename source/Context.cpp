@@ -1,11 +1,11 @@
 #include "Context.h"
 #include "LaserFrameGenerator.h"
-#include "InputManager.h"
 #include "Shapes.h"
 #include "Object.h"
 #include "Point2D.h"
-#include "Matrix3x3.h"
+#include "Matrix3X3.h"
 #include "EventManager.h"
+#include "Profiler.h"
 
 GameContext::GameContext(LaserFrameGenerator& laserGen, InputManager& inputManager, ShapeGenerator& shapeGen) :
     m_laserGen(laserGen),
@@ -20,12 +20,47 @@ GameContext::GameContext(LaserFrameGenerator& laserGen, InputManager& inputManag
 
 void GameContext::UpdatePools()
 {
+    PROFILE_SCOPE("UpdatePools");
     m_BulletPool.UpdateAll(m_deltaT);
     m_AsteroidPool.UpdateAll(m_deltaT);
     m_ShipPool.UpdateAll(*this);
+    ResolveCollisions();
+}
+
+void GameContext::ResolveCollisions()
+{
+    PROFILE_SCOPE("ResolveCollisions");
+    AsteroidPool& asteroids = m_AsteroidPool;
+    BulletPool& bullets = m_BulletPool;
+    m_Hits.clear();
+    m_AsteroidRadius.resize(asteroids.activeCount);
+    for (int i = 0; i < asteroids.activeCount; i++)
+        m_AsteroidRadius[i] = Asteroid::Radius(asteroids.data[i].m_Size);
+    m_AsteroidGrid.Build(asteroids.posX.data(), asteroids.posY.data(), m_AsteroidRadius.data(), asteroids.activeCount, BulletRadius);
+    // An asteroid can take several bullets in one frame, but none once it is destroyed
+    auto damage = [&asteroids] (int a)
+    {
+        int& hitPoints = asteroids.data[a].m_HitPoints;
+        if (hitPoints <= 0)
+            return false;
+        hitPoints--;
+        return true;
+    };
+    m_AsteroidGrid.FindHits(bullets.posX.data(), bullets.posY.data(), bullets.activeCount, BulletRadius, damage, m_Hits);
+    // Hit indices refer to the pools as they are now; apply and record them before anything is removed
+    m_Impacts.clear();
+    for (const SpatialHash::Hit& hit : m_Hits)
+    {
+        bullets.lifetime[hit.point] = 0.0f;
+        m_Impacts.push_back(Impact { Point2D(bullets.posX[hit.point], bullets.posY[hit.point]), asteroids.data[hit.circle].m_HitPoints <= 0 });
+    }
+    bullets.RemoveDead();
+    asteroids.RemoveDead();
 }
 void GameContext::DrawPools()
 {
+    PROFILE_SCOPE("DrawPools");
     m_ShipPool.DrawAll(*this);
     m_BulletPool.DrawAll(*this);
+    m_shapeGen.Flush();
 }
\ No newline at end of file
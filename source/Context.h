@@ -2,7 +2,9 @@
 //#include "Point2D.h"
 //#include "Matrix3x3.h"
 //#include "EventManager.h"
+#include <vector>
 #include "Object.h"
+#include "SpatialHash.h"
 
 //class LaserFrameGenerator;
 //class InputManager;
@@ -20,10 +22,26 @@ public:
     const Mat3& GetWorldMatrix() const { return m_WorldMatrix; }
     void SetDeltaTime(float dt) { m_deltaT = dt; }
     float GetDeltaTime() const { return m_deltaT; }
+    // Fraction of a fixed step elapsed since the last update; drawing moves entities back by the rest
+    void SetInterpolation(float alpha) { m_Alpha = alpha; }
+    float GetInterpolation() const { return m_Alpha; }
+    // How far back along its motion an entity is drawn, in seconds
+    float GetDrawLag() const { return (1.0f - m_Alpha) * m_deltaT; }
     void SetMousePos(float mouseX, float mouseY) { m_MousePos = Point2D(mouseX, mouseY); }
     const Point2D& GetMousePos() const { return m_MousePos; }
     void UpdatePools();
     void DrawPools();
+    // Where a bullet struck an asteroid in the last ResolveCollisions, and whether that asteroid was
+    // destroyed. Recorded before dead entities are removed, so nothing here refers to pool slots.
+    struct Impact
+    {
+        Point2D position; // the bullet's
+        bool destroyed;
+    };
+    // Bullets inside a live asteroid take one hit point off it and are spent
+    void ResolveCollisions();
+    const std::vector<Impact>& GetImpacts() const { return m_Impacts; }
+    static constexpr float BulletRadius = 0.01f;
 
     BulletPool m_BulletPool;
     AsteroidPool m_AsteroidPool;
@@ -35,4 +53,9 @@ private:
     Mat3 m_WorldMatrix;
     Point2D m_MousePos;
     float m_deltaT;
+    float m_Alpha = 1.0f;
+    SpatialHash m_AsteroidGrid;
+    std::vector<float> m_AsteroidRadius;
+    std::vector<SpatialHash::Hit> m_Hits;
+    std::vector<Impact> m_Impacts;
 };
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <stdexcept>
+#include "DacPlayback.h"
+
+// Sleep until this close to a deadline, then yield until it passes; as FixedStepClock
+static constexpr std::chrono::microseconds SPIN_MARGIN(500);
+
+DacPlayback::DacPlayback(Sink sink, float pointsPerSecond, size_t capacity) :
+    m_Sink(std::move(sink)),
+    m_PointsPerSecond(pointsPerSecond),
+    m_Points(capacity),
+    m_FrameSizes(1024)
+{
+    if (pointsPerSecond <= 0.0f)
+        throw std::invalid_argument("DacPlayback needs a positive point rate");
+    m_Current.resize(m_Points.Capacity());
+}
+
+DacPlayback::~DacPlayback()
+{
+    Stop();
+}
+
+void DacPlayback::Start()
+{
+    if (m_Thread.joinable())
+        return;
+    // Enough room for a chunk that catches up on the whole allowed backlog
+    m_Chunk.resize(size_t(m_PointsPerSecond * MaxBacklogSeconds) + 1);
+    m_Playing = m_Settings;
+    m_Stop = false;
+    m_Thread = std::thread(&DacPlayback::PlaybackLoop, this);
+}
+
+void DacPlayback::Stop()
+{
+    if (!m_Thread.joinable())
+        return;
+    m_Stop = true;
+    m_Thread.join();
+}
+
+bool DacPlayback::SubmitFrame(const LaserFrame& frame)
+{
+    if (frame.empty())
+        return true;
+    m_FramesSubmitted++;
+    // Only this thread pushes, so a length slot checked free here stays free. Points go in
+    // before the length: once the length is visible, so is the whole frame.
+    if (m_FrameSizes.Size() == m_FrameSizes.Capacity() || !m_Points.TryPushMany(frame.data(), frame.size()))
+    {
+        m_Overruns++;
+        return false;
+    }
+    m_FrameSizes.TryPush(uint32_t(frame.size()));
+    m_MaxFill = std::max(m_MaxFill, m_Points.Size());
+    return true;
+}
+
+DacPlayback::Stats DacPlayback::GetStats() const
+{
+    Stats stats;
+    stats.framesSubmitted = m_FramesSubmitted;
+    stats.overruns = m_Overruns;
+    stats.framesPlayed = m_FramesPlayed.load(std::memory_order_relaxed);
+    stats.underruns = m_Underruns.load(std::memory_order_relaxed);
+    stats.repeatedFrames = m_RepeatedFrames.load(std::memory_order_relaxed);
+    stats.pointsPlayed = m_PointsPlayed.load(std::memory_order_relaxed);
+    stats.parkedPoints = m_ParkedPoints.load(std::memory_order_relaxed);
+    stats.skippedPoints = m_SkippedPoints.load(std::memory_order_relaxed);
+    stats.fillPoints = m_Points.Size();
+    stats.maxFillPoints = m_MaxFill;
+    uint64_t wakes = m_Wakes.load(std::memory_order_relaxed);
+    stats.meanWakeLateMs = wakes ? m_WakeLateTotalMs.load(std::memory_order_relaxed) / double(wakes) : 0.0;
+    stats.maxWakeLateMs = m_MaxWakeLateMs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool DacPlayback::TakeFrame()
+{
+    uint32_t size;
+    if (!m_FrameSizes.TryPop(size))
+        return false;
+    m_CurrentSize = m_Points.TryPopMany(m_Current.data(), size);
+    m_Position = 0;
+    m_FramesPlayed.fetch_add(1, std::memory_order_relaxed);
+    return m_CurrentSize > 0;
+}
+
+LaserPoint DacPlayback::NextPoint()
+{
+    // Parked stays at the boundary, so every point checks for a new frame
+    if (m_Position >= m_CurrentSize)
+    {
+        if (TakeFrame())
+            m_Parked = false;
+        else
+        {
+            if (!m_Parked)
+                m_Underruns.fetch_add(1, std::memory_order_relaxed);
+            if (m_Playing.underrun == Underrun::REPEAT_FRAME && m_CurrentSize > 0)
+            {
+                m_RepeatedFrames.fetch_add(1, std::memory_order_relaxed);
+                m_Position = 0;
+            }
+            else
+            {
+                m_Parked = true;
+                m_Position = m_CurrentSize;
+                m_ParkedPoints.fetch_add(1, std::memory_order_relaxed);
+                return LaserPoint { m_Playing.parkX, m_Playing.parkY, 0, 0, 0, 0 };
+            }
+        }
+    }
+    return m_Current[m_Position++];
+}
+
+void DacPlayback::PlaybackLoop()
+{
+    m_CurrentSize = 0;
+    m_Position = 0;
+    m_Parked = false;
+    uint64_t emitted = 0;
+    uint64_t maxBacklog = uint64_t(double(m_PointsPerSecond) * MaxBacklogSeconds);
+    double lateTotalMs = 0.0;
+    double lateMaxMs = 0.0;
+    uint64_t wakes = 0;
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start;
+    while (!m_Stop.load(std::memory_order_relaxed))
+    {
+        Clock::time_point now = Clock::now();
+        if (deadline - now > SPIN_MARGIN)
+            std::this_thread::sleep_until(deadline - SPIN_MARGIN);
+        while ((now = Clock::now()) < deadline)
+            std::this_thread::yield();
+        double lateMs = std::chrono::duration<double, std::milli>(now - deadline).count();
+        lateTotalMs += lateMs;
+        lateMaxMs = std::max(lateMaxMs, lateMs);
+        wakes++;
+        m_Wakes.store(wakes, std::memory_order_relaxed);
+        m_WakeLateTotalMs.store(lateTotalMs, std::memory_order_relaxed);
+        m_MaxWakeLateMs.store(lateMaxMs, std::memory_order_relaxed);
+
+        // Every point due since start, so late wake-ups are made up in the next chunk
+        uint64_t due = uint64_t(std::chrono::duration<double>(now - start).count() * double(m_PointsPerSecond));
+        if (due - emitted > maxBacklog)
+        {
+            m_SkippedPoints.fetch_add(due - emitted - maxBacklog, std::memory_order_relaxed);
+            emitted = due - maxBacklog;
+        }
+        size_t count = size_t(due - emitted);
+        for (size_t i = 0; i < count; i++)
+            m_Chunk[i] = NextPoint();
+        if (count && m_Sink)
+            m_Sink(m_Chunk.data(), count);
+        emitted += count;
+        m_PointsPlayed.store(emitted, std::memory_order_relaxed);
+        deadline += m_Playing.chunkPeriod;
+        if (deadline < now)
+            deadline = now;
+    }
+}
+
+PointFileWriter::PointFileWriter(const std::string& path) : m_Path(path), m_File(std::fopen(path.c_str(), "wb"))
+{
+    if (!m_File)
+        throw std::runtime_error("Failed to create point file " + path);
+}
+
+PointFileWriter::~PointFileWriter()
+{
+    if (m_File)
+        std::fclose(m_File);
+}
+
+void PointFileWriter::Write(const LaserPoint* points, size_t count)
+{
+    if (!m_File)
+        return;
+    m_Buffer.resize(count * 8);
+    uint8_t* p = m_Buffer.data();
+    for (size_t i = 0; i < count; i++, p += 8)
+    {
+        const LaserPoint& point = points[i];
+        p[0] = uint8_t(uint16_t(point.x));
+        p[1] = uint8_t(uint16_t(point.x) >> 8);
+        p[2] = uint8_t(uint16_t(point.y));
+        p[3] = uint8_t(uint16_t(point.y) >> 8);
+        p[4] = point.r;
+        p[5] = point.g;
+        p[6] = point.b;
+        p[7] = point.flags;
+    }
+    if (std::fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_File) != m_Buffer.size())
+        m_Failed = true;
+    m_Points += count;
+}
+
+void PointFileWriter::Close()
+{
+    if (!m_File)
+        return;
+    bool failed = std::fclose(m_File) != 0 || m_Failed;
+    m_File = nullptr;
+    if (failed)
+        throw std::runtime_error("Failed to write point file " + m_Path);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LaserFrameGenerator.h"
+#include "SpscQueue.h"
+
+// Plays frames out point by point at a fixed scan rate, the way a DAC does.
+// The producer queues whole frames with SubmitFrame; a playback thread drains
+// them through lock-free SPSC rings (points, and the length of each frame)
+// and hands the sink a chunk of points every chunk period, as many as are due
+// at the point rate since Start, so the rate is exact on average whatever the
+// wake-up jitter. A new frame is only taken at the end of the current one.
+// When none is queued at that boundary the engine underruns: it repeats the
+// last frame or parks blanked at the park position, never emitting stale or
+// partial data. A frame that does not fit in the ring is dropped (overrun).
+class DacPlayback
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    // Called on the playback thread; an empty sink discards the points
+    using Sink = std::function<void(const LaserPoint*, size_t)>;
+    enum class Underrun
+    {
+        REPEAT_FRAME, // replay the last frame (parks until there is one)
+        BLANK_PARK    // blanked points at the park position
+    };
+    struct Stats
+    {
+        uint64_t framesSubmitted = 0;
+        uint64_t overruns = 0;       // frames dropped by SubmitFrame for lack of room
+        uint64_t framesPlayed = 0;   // new frames started, repeats not counted
+        uint64_t underruns = 0;      // frame boundaries with nothing queued (a park counts once)
+        uint64_t repeatedFrames = 0;
+        uint64_t pointsPlayed = 0;
+        uint64_t parkedPoints = 0;
+        uint64_t skippedPoints = 0;  // schedule dropped after the sink fell more than MaxBacklog behind
+        size_t fillPoints = 0;       // points queued now
+        size_t maxFillPoints = 0;
+        double meanWakeLateMs = 0.0; // playback thread waking after its chunk deadline
+        double maxWakeLateMs = 0.0;
+    };
+    // capacity: ring size in points, rounded up to a power of two; frames up to this size fit
+    DacPlayback(Sink sink, float pointsPerSecond, size_t capacity = 1 << 16);
+    ~DacPlayback();
+    DacPlayback(const DacPlayback&) = delete;
+    DacPlayback& operator=(const DacPlayback&) = delete;
+    // Producer thread. Settings take effect at the next Start; a running playback keeps its copy.
+    void SetUnderrun(Underrun mode) { m_Settings.underrun = mode; }
+    void SetParkPosition(int16_t x, int16_t y) { m_Settings.parkX = x; m_Settings.parkY = y; }
+    void SetChunkPeriod(std::chrono::microseconds period) { m_Settings.chunkPeriod = period; }
+    void Start();
+    // Stops the playback thread; queued points are left unplayed
+    void Stop();
+    // Producer thread only. False if the frame was dropped as an overrun; empty frames are ignored.
+    bool SubmitFrame(const LaserFrame& frame);
+    // Snapshot; safe from the producer thread while playing
+    Stats GetStats() const;
+
+    static constexpr double MaxBacklogSeconds = 0.1;
+private:
+    struct Settings
+    {
+        Underrun underrun = Underrun::REPEAT_FRAME;
+        int16_t parkX = 0;
+        int16_t parkY = 0;
+        std::chrono::microseconds chunkPeriod { 1000 };
+    };
+    void PlaybackLoop();
+    LaserPoint NextPoint();
+    bool TakeFrame();
+
+    Sink m_Sink;
+    float m_PointsPerSecond;
+    Settings m_Settings;
+    SpscQueue<LaserPoint> m_Points;
+    SpscQueue<uint32_t> m_FrameSizes;
+    std::thread m_Thread;
+    std::atomic<bool> m_Stop { false };
+
+    // Playback thread
+    Settings m_Playing; // copied from m_Settings by Start before the thread is launched
+    std::vector<LaserPoint> m_Current;
+    size_t m_CurrentSize = 0;
+    size_t m_Position = 0;
+    bool m_Parked = false;
+    std::vector<LaserPoint> m_Chunk;
+
+    // Producer counters
+    uint64_t m_FramesSubmitted = 0;
+    uint64_t m_Overruns = 0;
+    size_t m_MaxFill = 0;
+    // Playback counters, read by GetStats while playing
+    std::atomic<uint64_t> m_FramesPlayed { 0 };
+    std::atomic<uint64_t> m_Underruns { 0 };
+    std::atomic<uint64_t> m_RepeatedFrames { 0 };
+    std::atomic<uint64_t> m_PointsPlayed { 0 };
+    std::atomic<uint64_t> m_ParkedPoints { 0 };
+    std::atomic<uint64_t> m_SkippedPoints { 0 };
+    std::atomic<uint64_t> m_Wakes { 0 };
+    std::atomic<double> m_WakeLateTotalMs { 0.0 };
+    std::atomic<double> m_MaxWakeLateMs { 0.0 };
+};
+
+// Writes played points to a file, 8 bytes each, little endian:
+// i16 x, i16 y, u8 r, g, b, flags. Buffered through stdio.
+class PointFileWriter
+{
+public:
+    // Throws std::runtime_error if the file cannot be created
+    explicit PointFileWriter(const std::string& path);
+    ~PointFileWriter();
+    PointFileWriter(const PointFileWriter&) = delete;
+    PointFileWriter& operator=(const PointFileWriter&) = delete;
+    void Write(const LaserPoint* points, size_t count);
+    // Throws std::runtime_error if any write failed
+    void Close();
+    uint64_t GetPointsWritten() const { return m_Points; }
+private:
+    std::string m_Path;
+    FILE* m_File;
+    std::vector<uint8_t> m_Buffer;
+    uint64_t m_Points = 0;
+    bool m_Failed = false;
+};
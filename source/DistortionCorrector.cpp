@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "DistortionCorrector.h"
+#include "Point2D.h"
+
+static float constexpr DEG_TO_RAD = 0.01745329251994f;
+// Largest r^2 inside the [-1,1] square (the corners)
+static float constexpr MAX_RADIUS_SQ = 2.0f;
+
+DistortionCorrector::DistortionCorrector(float maxAngle, int resolution) :
+    m_MaxAngle(maxAngle),
+    m_RadiusSqToIndex(0.0f),
+    m_Mode(Mode::EXACT),
+    m_Gain(std::max(resolution, 2) + 1)
+{
+    BuildTable();
+}
+
+void DistortionCorrector::SetMaxAngle(float maxAngle)
+{
+    m_MaxAngle = maxAngle;
+    BuildTable();
+}
+
+void DistortionCorrector::BuildTable()
+{
+    const int last = int(m_Gain.size()) - 1;
+    m_RadiusSqToIndex = float(last) / MAX_RADIUS_SQ;
+    // Built in double so the table itself adds no error on top of the interpolation
+    const double k = double(m_MaxAngle) * double(DEG_TO_RAD);
+    m_Gain[0] = 1.0f; // limit of atan(k r) / (k r) as r -> 0
+    for (int i = 1; i <= last; i++)
+    {
+        double r = std::sqrt(double(i) / double(m_RadiusSqToIndex));
+        m_Gain[i] = float(std::atan(k * r) / (k * r));
+    }
+}
+
+void DistortionCorrector::ApplyExact(Point2D& p) const
+{
+    // Input: x,y in [-1,1]
+    float r = sqrtf(p.x * p.x + p.y * p.y);
+    float th = atan2f(p.y, p.x);
+
+    // normalized radius -> angle space
+    float angleDeg = r * m_MaxAngle;
+
+    // *** distortion correction ***
+    float correctedAngleDeg = atanf(angleDeg * DEG_TO_RAD) / DEG_TO_RAD;
+
+    // angle space -> back to normalized
+    float correctedR = correctedAngleDeg / m_MaxAngle;
+
+    // build corrected coordinate
+    p.x = correctedR * cosf(th);
+    p.y = correctedR * sinf(th);
+}
+
+void DistortionCorrector::ApplyLUT(Point2D& p) const
+{
+    float rsq = p.x * p.x + p.y * p.y;
+    if (!(rsq < MAX_RADIUS_SQ))
+    {
+        // Outside the table (or NaN), let the exact path deal with it
+        ApplyExact(p);
+        return;
+    }
+    float fi = rsq * m_RadiusSqToIndex;
+    int i = std::min(static_cast<int>(fi), int(m_Gain.size()) - 2);
+    float frac = fi - float(i);
+    float gain = m_Gain[i] + (m_Gain[i + 1] - m_Gain[i]) * frac;
+    p *= gain;
+}
+
+void DistortionCorrector::ApplyBatch(float* x, float* y, int count) const
+{
+    for (int i = 0; i < count; i++)
+    {
+        Point2D p(x[i], y[i]);
+        Apply(p);
+        x[i] = p.x;
+        y[i] = p.y;
+    }
+}
+
+DistortionCorrector::ErrorReport DistortionCorrector::MeasureError(float dacScale, int gridSize) const
+{
+    ErrorReport report;
+    gridSize = std::max(gridSize, 2);
+    double sum = 0.0;
+    for (int iy = 0; iy < gridSize; iy++)
+    {
+        for (int ix = 0; ix < gridSize; ix++)
+        {
+            Point2D p(-1.0f + 2.0f * float(ix) / float(gridSize - 1), -1.0f + 2.0f * float(iy) / float(gridSize - 1));
+            Point2D exact = p;
+            Point2D lut = p;
+            ApplyExact(exact);
+            ApplyLUT(lut);
+            float err = (exact - lut).Length() * dacScale;
+            report.maxErrorDAC = std::max(report.maxErrorDAC, err);
+            sum += err;
+            report.samples++;
+        }
+    }
+    report.meanErrorDAC = float(sum / double(report.samples));
+    return report;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "Point2D.h"
+
+// Pre-distorts normalized [-1,1] positions so that a galvo with a given
+// optical half-angle draws straight lines on a flat screen.
+// The correction is purely radial, so the LUT stores the radial gain
+// correctedR / r indexed by r^2 (no sqrt needed on lookup) and
+// interpolates linearly between entries.
+class DistortionCorrector
+{
+public:
+    enum class Mode
+    {
+        EXACT,
+        LUT
+    };
+    struct ErrorReport
+    {
+        float maxErrorDAC = 0.0f;   // worst deviation from the exact path, in DAC units
+        float meanErrorDAC = 0.0f;
+        int samples = 0;
+    };
+    DistortionCorrector(float maxAngle, int resolution = 1024);
+    void SetMaxAngle(float maxAngle);
+    void SetMode(Mode mode) { m_Mode = mode; }
+    Mode GetMode() const { return m_Mode; }
+    void Apply(Point2D& p) const
+    {
+        if (m_Mode == Mode::LUT)
+            ApplyLUT(p);
+        else
+            ApplyExact(p);
+    }
+    void ApplyExact(Point2D& p) const;
+    void ApplyLUT(Point2D& p) const;
+    // In-place correction of count points stored as separate x/y arrays
+    void ApplyBatch(float* x, float* y, int count) const;
+    // Compares LUT against exact math on a gridSize x gridSize sweep of [-1,1]^2.
+    // dacScale is the value a normalized 1.0 maps to (LaserFrameGenerator's m_MaxValue).
+    ErrorReport MeasureError(float dacScale, int gridSize = 512) const;
+private:
+    void BuildTable();
+    float m_MaxAngle;
+    float m_RadiusSqToIndex;
+    Mode m_Mode;
+    std::vector<float> m_Gain; // correctedR / r sampled uniformly in r^2 over [0, 2]
+};
@@ -0,0 +1,34 @@
+#include "EntityPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENTITYKERNEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+void EntityKernel::Advance(float* value, const float* rate, int count, float dt)
+{
+    int k = 0;
+#ifdef ENTITYKERNEL_SSE2
+    const __m128 vdt = _mm_set1_ps(dt);
+    for (; k + 4 <= count; k += 4)
+    {
+        __m128 v = _mm_loadu_ps(value + k);
+        __m128 r = _mm_loadu_ps(rate + k);
+        _mm_storeu_ps(value + k, _mm_add_ps(v, _mm_mul_ps(r, vdt)));
+    }
+#endif
+    for (; k < count; k++)
+        value[k] += rate[k] * dt;
+}
+
+void EntityKernel::Decay(float* value, int count, float dt)
+{
+    int k = 0;
+#ifdef ENTITYKERNEL_SSE2
+    const __m128 vdt = _mm_set1_ps(dt);
+    for (; k + 4 <= count; k += 4)
+        _mm_storeu_ps(value + k, _mm_sub_ps(_mm_loadu_ps(value + k), vdt));
+#endif
+    for (; k < count; k++)
+        value[k] -= dt;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+#include "Point2D.h"
+
+// Batched per-frame integration for EntityPool's arrays (SSE2 where available)
+class EntityKernel
+{
+public:
+    // value[k] += rate[k] * dt
+    static void Advance(float* value, const float* rate, int count, float dt);
+    // value[k] -= dt
+    static void Decay(float* value, int count, float dt);
+};
+
+// Structure-of-arrays entity storage. The fields UpdateAll touches every frame
+// (position, velocity, angle, angular velocity, lifetime) each live in their
+// own contiguous array; everything else is a Data record in a parallel array.
+// Removal swaps the last active entity into the hole, as the AoS pools do, so
+// indices are not stable across Deactivate.
+template <typename Data>
+class EntityPool
+{
+public:
+    explicit EntityPool(int capacity) :
+        posX(capacity), posY(capacity), velX(capacity), velY(capacity),
+        angle(capacity), angVel(capacity), lifetime(capacity), data(capacity), m_Capacity(capacity) {}
+
+    int Capacity() const { return m_Capacity; }
+    Point2D Pos(int index) const { return Point2D(posX[index], posY[index]); }
+
+    // Returns the new index, or -1 when the pool is full
+    int Spawn(Point2D pos, Point2D vel, float a, float av, float life, const Data& d)
+    {
+        if (activeCount >= m_Capacity) return -1;
+        int i = activeCount++;
+        posX[i] = pos.x;
+        posY[i] = pos.y;
+        velX[i] = vel.x;
+        velY[i] = vel.y;
+        angle[i] = a;
+        angVel[i] = av;
+        lifetime[i] = life;
+        data[i] = d;
+        return i;
+    }
+
+    void Deactivate(int index)
+    {
+        if (index < 0 || index >= activeCount) return;
+        int last = activeCount - 1;
+        posX[index] = posX[last];
+        posY[index] = posY[last];
+        velX[index] = velX[last];
+        velY[index] = velY[last];
+        angle[index] = angle[last];
+        angVel[index] = angVel[last];
+        lifetime[index] = lifetime[last];
+        data[index] = data[last];
+        activeCount--;
+    }
+
+    // pos += vel * dt, angle += angVel * dt
+    void Integrate(float dt)
+    {
+        EntityKernel::Advance(posX.data(), velX.data(), activeCount, dt);
+        EntityKernel::Advance(posY.data(), velY.data(), activeCount, dt);
+        EntityKernel::Advance(angle.data(), angVel.data(), activeCount, dt);
+    }
+
+    void Age(float dt)
+    {
+        EntityKernel::Decay(lifetime.data(), activeCount, dt);
+    }
+
+    // Swap-removes every entity dead(index) returns true for
+    template <typename Predicate>
+    void RemoveIf(Predicate dead)
+    {
+        for (int i = 0; i < activeCount; )
+        {
+            if (dead(i))
+                Deactivate(i); // swaps last active in
+            else
+                ++i;
+        }
+    }
+
+    std::vector<float> posX, posY;
+    std::vector<float> velX, velY;
+    std::vector<float> angle, angVel;
+    std::vector<float> lifetime; // seconds remaining
+    std::vector<Data> data;
+    int activeCount = 0;
+
+private:
+    int m_Capacity;
+};
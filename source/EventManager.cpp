@@ -0,0 +1,49 @@
+#include "EventManager.h"
+
+EventManager::EventId EventManager::Intern(const std::string& name)
+{
+    auto [it, inserted] = m_Ids.try_emplace(name, EventId(m_Names.size()));
+    if (inserted)
+    {
+        m_Names.push_back(name);
+        m_Listeners.emplace_back();
+    }
+    return it->second;
+}
+
+EventManager::EventId EventManager::Find(const std::string& name) const
+{
+    auto it = m_Ids.find(name);
+    return it == m_Ids.end() ? InvalidEvent : it->second;
+}
+
+void EventManager::Subscribe(EventId id, Callback callback)
+{
+    if (m_Emitting > 0)
+        m_Pending.emplace_back(id, std::move(callback));
+    else
+        m_Listeners[id].push_back(std::move(callback));
+}
+
+void EventManager::AddPending()
+{
+    for (auto& [id, callback] : m_Pending)
+        m_Listeners[id].push_back(std::move(callback));
+    m_Pending.clear();
+}
+
+void EventManager::Emit(const std::string& name)
+{
+    EventId id = Find(name);
+    if (id != InvalidEvent)
+        Emit(id);
+}
+
+void EventManager::Dispatch()
+{
+    // Swapped out so listeners can queue more without invalidating the loop; both keep their capacity
+    m_Dispatching.swap(m_Queued);
+    for (EventId id : m_Dispatching)
+        Emit(id);
+    m_Dispatching.clear();
+}
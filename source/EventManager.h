@@ -1,30 +1,62 @@
 #pragma once
+#include <cstdint>
 #include <functional>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <string>
 
+// Named gameplay events. Names are interned once into dense integer IDs, so
+// hot paths emit by ID: an index into the listener table, no string hashing.
+// The string overloads remain for setup code and look the name up each call.
+// Callbacks are std::function, which stores small captures such as [&] or
+// [this] inline, so subscribing allocates only the listener list.
 class EventManager
 {
 public:
-    // Map event name -> list of callbacks
-    std::unordered_map<std::string, std::vector<std::function<void()>>> listeners;
+    using EventId = uint32_t;
+    using Callback = std::function<void()>;
+    static constexpr EventId InvalidEvent = UINT32_MAX;
 
-    // Subscribe to an event
-    void Subscribe(const std::string& name, std::function<void()> callback)
-    {
-        listeners[name].push_back(std::move(callback));
-    }
+    // Returns the event's ID, registering the name on first use
+    EventId Intern(const std::string& name);
+    // InvalidEvent if the name was never interned
+    EventId Find(const std::string& name) const;
+    const std::string& GetName(EventId id) const { return m_Names[id]; }
+    size_t GetEventCount() const { return m_Names.size(); }
+
+    // Subscribe to an event. From inside a listener the subscription is held back
+    // until the outermost Emit returns, so the running callbacks never move.
+    void Subscribe(EventId id, Callback callback);
+    void Subscribe(const std::string& name, Callback callback) { Subscribe(Intern(name), std::move(callback)); }
 
-    // Emit/Trigger an event
-    void Emit(const std::string& name)
+    // Emit/Trigger an event. Listeners subscribed during the call first run on
+    // the next emit.
+    void Emit(EventId id)
     {
-        if (listeners.contains(name))
-        {
-            for (auto& callback : listeners[name])
-            {
-                callback();
-            }
-        }
+        m_Emitting++;
+        // Indexed rather than iterated: a listener may intern an event and move the table
+        for (size_t i = 0, count = m_Listeners[id].size(); i < count; i++)
+            m_Listeners[id][i]();
+        if (--m_Emitting == 0 && !m_Pending.empty())
+            AddPending();
     }
+    void Emit(const std::string& name);
+
+    // Defers an emit to the next Dispatch, which runs queued events in order.
+    // Events queued by listeners during Dispatch wait for the following one;
+    // listeners must not call Dispatch themselves.
+    void Queue(EventId id) { m_Queued.push_back(id); }
+    void Dispatch();
+
+private:
+    void AddPending();
+
+    std::unordered_map<std::string, EventId> m_Ids;
+    std::vector<std::string> m_Names;
+    std::vector<std::vector<Callback>> m_Listeners; // by ID
+    std::vector<EventId> m_Queued;
+    std::vector<EventId> m_Dispatching;
+    std::vector<std::pair<EventId, Callback>> m_Pending; // subscribed during an emit
+    int m_Emitting = 0; // nesting depth of Emit
 };
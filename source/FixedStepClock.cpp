@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "FixedStepClock.h"
+
+// Sleep granularity can be a full scheduler tick, so stop sleeping this early and yield instead
+static constexpr std::chrono::microseconds SPIN_MARGIN(1500);
+
+FixedStepClock::FixedStepClock(double stepSeconds, int maxCatchUpSteps) :
+    m_Step(std::max(stepSeconds, 1e-6)),
+    m_MaxCatchUp(std::max(maxCatchUpSteps, 1))
+{
+}
+
+void FixedStepClock::SetFrameCap(double framesPerSecond)
+{
+    m_Period = (framesPerSecond > 0.0) ?
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond)) : Clock::duration::zero();
+    m_Deadline = Clock::now() + m_Period;
+}
+
+void FixedStepClock::Reset()
+{
+    m_Accumulator = 0.0;
+    m_Started = false;
+    m_Stats = Stats {};
+    m_IntervalMean = 0.0;
+    m_IntervalM2 = 0.0;
+}
+
+int FixedStepClock::BeginFrame()
+{
+    Clock::time_point now = Clock::now();
+    if (!m_Started)
+    {
+        // The first frame only starts the clock
+        m_Started = true;
+        m_Last = now;
+        m_Deadline = now + m_Period;
+        m_Stats.frames++;
+        return 0;
+    }
+    double interval = std::chrono::duration<double>(now - m_Last).count();
+    m_Last = now;
+    m_Stats.frames++;
+    double ms = interval * 1000.0;
+    double n = double(m_Stats.frames - 1);
+    double delta = ms - m_IntervalMean;
+    m_IntervalMean += delta / n;
+    m_IntervalM2 += delta * (ms - m_IntervalMean);
+    m_Stats.maxFrameMs = std::max(m_Stats.maxFrameMs, ms);
+
+    m_Accumulator += interval;
+    int steps = int(m_Accumulator / m_Step);
+    if (steps > m_MaxCatchUp)
+    {
+        m_Stats.droppedSteps += uint64_t(steps - m_MaxCatchUp);
+        steps = m_MaxCatchUp;
+        m_Accumulator = std::fmod(m_Accumulator, m_Step);
+    }
+    else
+    {
+        m_Accumulator -= double(steps) * m_Step;
+    }
+    m_Stats.steps += uint64_t(steps);
+    return steps;
+}
+
+void FixedStepClock::WaitForNextFrame()
+{
+    if (m_Period == Clock::duration::zero())
+        return;
+    Clock::time_point now = Clock::now();
+    if (now > m_Deadline)
+    {
+        // Late: count it and pace from now rather than rushing to catch up
+        m_Stats.missedDeadlines++;
+        m_Deadline = now + m_Period;
+        return;
+    }
+    if (m_Deadline - now > SPIN_MARGIN)
+        std::this_thread::sleep_until(m_Deadline - SPIN_MARGIN);
+    while (Clock::now() < m_Deadline)
+        std::this_thread::yield();
+    m_Deadline += m_Period;
+}
+
+FixedStepClock::Stats FixedStepClock::GetStats() const
+{
+    Stats stats = m_Stats;
+    uint64_t intervals = (m_Stats.frames > 1) ? m_Stats.frames - 1 : 0;
+    stats.meanFrameMs = m_IntervalMean;
+    stats.jitterMs = (intervals > 1) ? std::sqrt(m_IntervalM2 / double(intervals - 1)) : 0.0;
+    return stats;
+}
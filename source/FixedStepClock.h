@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Fixed-timestep game clock. Real time is accumulated every frame and paid
+// out in whole steps of a fixed length, so physics advances the same way
+// regardless of frame timing. After a long stall at most maxCatchUpSteps are
+// run and the rest of the backlog is dropped, so the simulation never spirals.
+// Alpha() is the leftover fraction of a step for interpolating the drawing.
+// An optional frame cap paces the loop: WaitForNextFrame() sleeps most of the
+// way to the next deadline and yields for the last stretch.
+class FixedStepClock
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    struct Stats
+    {
+        uint64_t frames = 0;
+        uint64_t steps = 0;
+        uint64_t droppedSteps = 0;    // backlog discarded by the catch-up limit
+        uint64_t missedDeadlines = 0; // capped frames that finished after their deadline
+        double meanFrameMs = 0.0;
+        double jitterMs = 0.0;        // standard deviation of the frame interval
+        double maxFrameMs = 0.0;
+    };
+    explicit FixedStepClock(double stepSeconds, int maxCatchUpSteps = 5);
+    // 0 disables the cap
+    void SetFrameCap(double framesPerSecond);
+    float GetStepSeconds() const { return float(m_Step); }
+    // Starts a frame: adds the real time since the last frame and returns how many steps to run
+    int BeginFrame();
+    // Fraction of a step accumulated beyond the steps run, 0..1
+    float Alpha() const { return float(m_Accumulator / m_Step); }
+    // Capped: waits for the frame deadline. Uncapped: returns at once.
+    void WaitForNextFrame();
+    // Clears the accumulator and the counters, and restarts timing from now
+    void Reset();
+    Stats GetStats() const;
+private:
+    double m_Step;
+    int m_MaxCatchUp;
+    Clock::duration m_Period {};
+    Clock::time_point m_Last;
+    Clock::time_point m_Deadline;
+    double m_Accumulator = 0.0;
+    bool m_Started = false;
+    Stats m_Stats;
+    // Welford running variance of the frame interval
+    double m_IntervalMean = 0.0;
+    double m_IntervalM2 = 0.0;
+};
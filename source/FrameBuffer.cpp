@@ -0,0 +1,44 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include "FrameBuffer.h"
+
+FrameArena::FrameArena(size_t bytes, std::pmr::memory_resource* upstream) :
+    m_Block(std::make_unique<std::byte[]>(bytes)),
+    m_Size(bytes),
+    m_Upstream(upstream)
+{
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    m_Allocations++;
+    uintptr_t base = reinterpret_cast<uintptr_t>(m_Block.get());
+    uintptr_t aligned = (base + m_Top + alignment - 1) & ~uintptr_t(alignment - 1);
+    size_t offset = size_t(aligned - base);
+    if (offset + bytes <= m_Size)
+    {
+        m_Top = offset + bytes;
+        m_Live++;
+        return m_Block.get() + offset;
+    }
+    m_HeapAllocations++;
+    return m_Upstream->allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    std::byte* ptr = static_cast<std::byte*>(p);
+    if (ptr >= m_Block.get() && ptr < m_Block.get() + m_Size)
+    {
+        // Only the newest block can be reclaimed; older ones wait until the arena empties
+        size_t offset = size_t(ptr - m_Block.get());
+        if (--m_Live == 0)
+            m_Top = 0;
+        else if (offset + bytes == m_Top)
+            m_Top = offset;
+        return;
+    }
+    m_Upstream->deallocate(p, bytes, alignment);
+}
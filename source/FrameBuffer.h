@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+struct FrameBufferStats
+{
+    size_t frames = 0;
+    size_t lastSize = 0;
+    size_t highWater = 0;     // largest frame seen, in points
+    size_t capacity = 0;
+    size_t reallocations = 0; // frames that had to grow the buffer, plus growth from Prepare itself
+};
+
+// Sizing policy for the per-frame point vectors (LaserFrame, SimFrame).
+// Prepare() is called instead of clear() at the start of every frame: it
+// records how the previous frame went and, once less than half the headroom
+// over the high water is left, reserves max(budget, high water plus headroom)
+// up front. A frame that grows by less than that does not reallocate midway,
+// and a steady-state frame never reallocates.
+class FrameBufferPolicy
+{
+public:
+    // Reserve at least this many points regardless of history
+    void SetBudget(size_t points) { m_Budget = points; }
+    // Extra room over the high water mark, as a fraction (0.25 = 25%)
+    void SetHeadroom(float fraction) { m_Headroom = std::max(fraction, 0.0f); }
+    const FrameBufferStats& GetStats() const { return m_Stats; }
+
+    template<class Vector>
+    void Prepare(Vector& buffer)
+    {
+        if (m_Stats.frames > 0)
+        {
+            m_Stats.lastSize = buffer.size();
+            m_Stats.highWater = std::max(m_Stats.highWater, buffer.size());
+            if (buffer.capacity() != m_Stats.capacity)
+                m_Stats.reallocations++;
+        }
+        m_Stats.frames++;
+        buffer.clear();
+        // Regrow only once half the headroom is used up, so a frame size that wanders
+        // up a little at a time regrows every few frames rather than every frame
+        const size_t headroom = size_t(float(m_Stats.highWater) * m_Headroom);
+        if (buffer.capacity() < std::max(m_Budget, m_Stats.highWater + headroom / 2))
+        {
+            buffer.reserve(std::max(m_Budget, m_Stats.highWater + headroom));
+            m_Stats.reallocations++;
+        }
+        m_Stats.capacity = buffer.capacity();
+    }
+private:
+    FrameBufferStats m_Stats;
+    size_t m_Budget = 0;
+    float m_Headroom = 0.25f;
+};
+
+// Memory resource that serves frame buffers from one block allocated up front.
+// Allocation is a pointer bump; freeing the most recent block gives its space
+// back, which is the pattern of a vector growing in place at the top of the
+// arena. Anything that does not fit goes to the upstream resource and is
+// counted, so a steady-state frame can be checked for zero heap allocations.
+// The arena must outlive every buffer that uses it.
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    explicit FrameArena(size_t bytes, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    size_t GetAllocations() const { return m_Allocations; }
+    size_t GetHeapAllocations() const { return m_HeapAllocations; }
+    size_t GetBytesInUse() const { return m_Top; }
+    size_t GetCapacity() const { return m_Size; }
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    std::unique_ptr<std::byte[]> m_Block;
+    size_t m_Size;
+    size_t m_Top = 0;
+    size_t m_Live = 0; // blocks currently handed out from the arena
+    size_t m_Allocations = 0;
+    size_t m_HeapAllocations = 0;
+    std::pmr::memory_resource* m_Upstream;
+};
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include "FramePipeline.h"
+#include "GalvoSimulator.h"
+#include "LaserFrameGenerator.h"
+
+static double Milliseconds(FramePipeline::Clock::time_point from, FramePipeline::Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+FramePipeline::FramePipeline(GalvoSimulator& simulator, float dt, int depth, Consumer consumer, bool consumerThread) :
+    m_Simulator(simulator),
+    m_Dt(dt),
+    m_Consumer(std::move(consumer)),
+    m_ConsumerThread(consumerThread),
+    m_Slots(std::max(depth, 1)),
+    // One spare entry so the stop marker always fits behind a full set of slots
+    m_Free(m_Slots.size() + 1),
+    m_ToSimulate(m_Slots.size() + 1),
+    m_ToConsume(m_Slots.size() + 1)
+{
+    for (int i = 0; i < int(m_Slots.size()); i++)
+        m_Free.Push(i);
+    m_SimulateThread = std::thread(&FramePipeline::SimulateLoop, this);
+    if (m_ConsumerThread)
+        m_ConsumeThread = std::thread(&FramePipeline::ConsumerLoop, this);
+}
+
+FramePipeline::~FramePipeline()
+{
+    Flush();
+    m_ToSimulate.Push(Stop);
+    m_SimulateThread.join();
+    if (m_ConsumeThread.joinable())
+        m_ConsumeThread.join();
+}
+
+void FramePipeline::Submit(const LaserFrame& frame)
+{
+    Clock::time_point submitted = Clock::now();
+    int slot;
+    if (m_ConsumerThread)
+    {
+        slot = m_Free.Pop();
+    }
+    else
+    {
+        // Slots only come back through our own consumer, so consume while waiting
+        while (!m_Free.TryPop(slot))
+            ConsumeSlot(m_ToConsume.Pop());
+    }
+    Clock::time_point acquired = Clock::now();
+    m_ProducerStats.generate.Add(Milliseconds(m_FrameStart, submitted));
+    m_ProducerStats.stall.Add(Milliseconds(submitted, acquired));
+
+    Slot& s = m_Slots[slot];
+    s.laser.assign(frame.begin(), frame.end());
+    s.start = m_FrameStart;
+    m_Submitted++;
+    m_ToSimulate.Push(slot);
+}
+
+int FramePipeline::Poll()
+{
+    int consumed = 0;
+    int slot;
+    while (!m_ConsumerThread && m_ToConsume.TryPop(slot))
+    {
+        ConsumeSlot(slot);
+        consumed++;
+    }
+    return consumed;
+}
+
+void FramePipeline::Flush()
+{
+    uint64_t consumed;
+    while ((consumed = m_Consumed.load(std::memory_order_acquire)) != m_Submitted)
+    {
+        if (m_ConsumerThread)
+            m_Consumed.wait(consumed, std::memory_order_acquire);
+        else
+            ConsumeSlot(m_ToConsume.Pop());
+    }
+}
+
+FramePipeline::Stats FramePipeline::GetStats() const
+{
+    Stats stats = m_ProducerStats;
+    stats.simulate = m_SimulateStats.simulate;
+    stats.consume = m_ConsumeStats.consume;
+    stats.latency = m_ConsumeStats.latency;
+    return stats;
+}
+
+void FramePipeline::SimulateLoop()
+{
+    while (true)
+    {
+        int slot = m_ToSimulate.Pop();
+        if (slot == Stop)
+        {
+            if (m_ConsumerThread)
+                m_ToConsume.Push(Stop);
+            return;
+        }
+        Clock::time_point start = Clock::now();
+        Slot& s = m_Slots[slot];
+        m_Simulator.Simulate(s.laser, m_Dt);
+        const SimFrame& simFrame = m_Simulator.GetSimFrame();
+        s.sim.assign(simFrame.begin(), simFrame.end());
+        m_SimulateStats.simulate.Add(Milliseconds(start, Clock::now()));
+        m_ToConsume.Push(slot);
+    }
+}
+
+void FramePipeline::ConsumerLoop()
+{
+    while (true)
+    {
+        int slot = m_ToConsume.Pop();
+        if (slot == Stop)
+            return;
+        ConsumeSlot(slot);
+    }
+}
+
+void FramePipeline::ConsumeSlot(int slot)
+{
+    Clock::time_point start = Clock::now();
+    Slot& s = m_Slots[slot];
+    m_Consumer(s.laser, s.sim);
+    Clock::time_point end = Clock::now();
+    m_ConsumeStats.consume.Add(Milliseconds(start, end));
+    m_ConsumeStats.latency.Add(Milliseconds(s.start, end));
+    m_Free.Push(slot);
+    m_Consumed.fetch_add(1, std::memory_order_release);
+    m_Consumed.notify_one();
+}
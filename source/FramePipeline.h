@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "GalvoSimulator.h"
+#include "LaserFrameGenerator.h"
+#include "SpscQueue.h"
+
+struct StageStats
+{
+    uint64_t frames = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    double AverageMs() const { return frames ? totalMs / double(frames) : 0.0; }
+    void Add(double ms)
+    {
+        frames++;
+        totalMs += ms;
+        if (ms > maxMs)
+            maxMs = ms;
+    }
+};
+
+// Runs galvo simulation and frame consumption (rendering, export) on their own
+// stages so frame N is simulated and shown while frame N+1 is generated.
+// The caller updates and generates, then hands each frame over with Submit().
+// Frames travel in depth slots (2 = double, 3 = triple buffering) that cycle
+// through lock-free SPSC queues: free -> simulate -> consume -> free. Submit
+// blocks only when every slot is in flight.
+// The consumer runs on a pipeline thread, or with consumerThread = false on
+// the caller's thread from Submit/Poll/Flush (for renderers tied to the window thread).
+class FramePipeline
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Consumer = std::function<void(const LaserFrame&, const SimFrame&)>;
+    struct Stats
+    {
+        StageStats generate;     // BeginFrame to Submit
+        StageStats stall;        // Submit waiting for a free slot
+        StageStats simulate;
+        StageStats consume;
+        StageStats latency;      // BeginFrame to the end of consume
+    };
+    FramePipeline(GalvoSimulator& simulator, float dt, int depth, Consumer consumer, bool consumerThread = true);
+    ~FramePipeline();
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+    int GetDepth() const { return int(m_Slots.size()); }
+    // Marks the start of generating the next frame (for the generate and latency counters)
+    void BeginFrame() { m_FrameStart = Clock::now(); }
+    // Copies the finished frame into a free slot and queues it for simulation
+    void Submit(const LaserFrame& frame);
+    // Caller-thread consumer: consumes every simulated frame that is ready, returns how many
+    int Poll();
+    // Waits until every submitted frame has been consumed
+    void Flush();
+    // Valid after Flush(); stages only write their own counters while frames are in flight
+    Stats GetStats() const;
+private:
+    struct Slot
+    {
+        LaserFrame laser;
+        SimFrame sim;
+        Clock::time_point start;
+    };
+    static constexpr int Stop = -1;
+    void SimulateLoop();
+    void ConsumerLoop();
+    void ConsumeSlot(int slot);
+    GalvoSimulator& m_Simulator;
+    float m_Dt;
+    Consumer m_Consumer;
+    bool m_ConsumerThread;
+    std::vector<Slot> m_Slots;
+    SpscQueue<int> m_Free;       // consumer -> caller
+    SpscQueue<int> m_ToSimulate; // caller -> simulate
+    SpscQueue<int> m_ToConsume;  // simulate -> consumer
+    std::atomic<uint64_t> m_Consumed { 0 };
+    uint64_t m_Submitted = 0;
+    Clock::time_point m_FrameStart;
+    Stats m_ProducerStats;       // generate and stall, caller thread
+    Stats m_SimulateStats;
+    Stats m_ConsumeStats;        // consume and latency
+    std::thread m_SimulateThread;
+    std::thread m_ConsumeThread;
+};
@@ -1,5 +1,7 @@
 #include "FrameRenderer.h"
 #include "GalvoSimulator.h"
+#include "Profiler.h"
+#include <algorithm>
 #include <stdexcept>
 #include <d2d1.h>
 #pragma comment(lib, "d2d1.lib")
@@ -52,6 +54,7 @@ void FrameRenderer::OnResize(int width, int height)
 
 void FrameRenderer::DrawFrame(const SimFrame& frame)
 {
+    PROFILE_SCOPE("DrawFrame");
     pRenderTarget->BeginDraw();
     pRenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black));
 
@@ -77,9 +80,40 @@ void FrameRenderer::DrawFrame(const SimFrame& frame)
         }
     }
 
+    DrawTimingOverlay();
     pRenderTarget->EndDraw();
 }
 
+void FrameRenderer::SetTimingOverlay(const std::vector<float>& stageMs, float budgetMs)
+{
+    m_OverlayMs = stageMs;
+    m_OverlayBudgetMs = budgetMs;
+}
+
+void FrameRenderer::DrawTimingOverlay()
+{
+    if (m_OverlayMs.empty() || m_OverlayBudgetMs <= 0.0f)
+        return;
+    static const D2D1::ColorF palette[] = {
+        D2D1::ColorF(D2D1::ColorF::Orange), D2D1::ColorF(D2D1::ColorF::DeepSkyBlue),
+        D2D1::ColorF(D2D1::ColorF::LimeGreen), D2D1::ColorF(D2D1::ColorF::Magenta),
+        D2D1::ColorF(D2D1::ColorF::Yellow), D2D1::ColorF(D2D1::ColorF::Tomato),
+    };
+    const float left = 10.0f;
+    const float width = 0.3f * float(m_width);
+    const float barHeight = 6.0f;
+    float y = 10.0f;
+    for (size_t i = 0; i < m_OverlayMs.size(); i++, y += barHeight + 3.0f)
+    {
+        float length = std::min(m_OverlayMs[i] / (2.0f * m_OverlayBudgetMs), 1.0f) * width;
+        pBrush->SetColor(palette[i % (sizeof(palette) / sizeof(palette[0]))]);
+        pRenderTarget->FillRectangle(D2D1::RectF(left, y, left + length, y + barHeight), pBrush);
+    }
+    // Budget marker halfway along
+    pBrush->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+    pRenderTarget->DrawLine(D2D1::Point2F(left + 0.5f * width, 8.0f), D2D1::Point2F(left + 0.5f * width, y), pBrush, 1.0f);
+}
+
 D2D1_POINT_2F FrameRenderer::SimToScreen(float x, float y) const
 {
     float winAspect = float(m_width) / float(m_height);
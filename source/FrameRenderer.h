@@ -1,9 +1,10 @@
 #pragma once
 #include <d2d1.h>
 #include <vector>
+#include <memory_resource>
 
 struct SimPoint;
-using SimFrame = std::vector<SimPoint>;
+using SimFrame = std::pmr::vector<SimPoint>;
 
 class FrameRenderer
 {
@@ -12,14 +13,19 @@ public:
     ~FrameRenderer();
     void OnResize(int width, int height);
     void DrawFrame(const SimFrame& frame);
+    // Bars drawn over every frame, one per stage, full width at twice budgetMs; empty hides them
+    void SetTimingOverlay(const std::vector<float>& stageMs, float budgetMs);
     int getScreenWidth() const { return m_width; }
     int getScreenHeight() const { return m_height; }
 
 private:
     D2D1_POINT_2F SimToScreen(float x, float y) const;
+    void DrawTimingOverlay();
     ID2D1Factory* pFactory = nullptr;
     ID2D1HwndRenderTarget* pRenderTarget = nullptr;
     ID2D1SolidColorBrush* pBrush = nullptr; // single reusable brush
     int m_width;
     int m_height;
+    std::vector<float> m_OverlayMs;
+    float m_OverlayBudgetMs = 16.7f;
 };
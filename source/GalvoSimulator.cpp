@@ -1,14 +1,69 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <memory>
+#include <memory_resource>
 #include "GalvoSimulator.h"
 #include "LaserFrameGenerator.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
 //#include <windows.h>
 //#include <string>
 
 
 static float constexpr DEG_TO_RAD = 0.01745329251994f;
 
+// Fixed-point constants, precomputed so no libm result reaches the FIXED path
+static constexpr int64_t DEG_TO_RAD_Q30 = 18740330;
+// atan(2^-i) in Q30 for the CORDIC rotation
+static constexpr int64_t CORDIC_ATAN_Q30[] = {
+    843314857, 497837829, 263043837, 133525159, 67021687, 33543516, 16775851, 8388437, 4194283, 2097149,
+    1048576, 524288, 262144, 131072, 65536, 32768, 16384, 8192, 4096, 2048,
+    1024, 512, 256, 128, 64, 32, 16, 8, 4, 2, 1 };
+
+static constexpr int64_t FIXED_SCALE_ENTRIES = 4096;
+
+// Conversions between float and fixed point round the same way everywhere: scaling by
+// a power of two is exact and llround is fully specified
+static int64_t ToFixed(float value, int fractionBits)
+{
+    return std::llround(std::ldexp(double(value), fractionBits));
+}
+
+static float FromFixed(int64_t value, int fractionBits)
+{
+    return float(std::ldexp(double(value), -fractionBits));
+}
+
+// floor(sqrt(n)); the floating-point estimate is corrected, so its rounding does not matter
+static int64_t FloorSqrt(int64_t n)
+{
+    int64_t s = int64_t(std::sqrt(double(n)));
+    while (s > 0 && s * s > n)
+        s--;
+    while ((s + 1) * (s + 1) <= n)
+        s++;
+    return s;
+}
+
+// tan of an angle in Q16 degrees, |angle| below 90, in Q30. CORDIC rotation: the
+// gain scales sine and cosine alike, so it cancels in the quotient.
+static int64_t FixedTan(int64_t degreesQ16)
+{
+    int64_t angle = (degreesQ16 * DEG_TO_RAD_Q30) >> 16;
+    int64_t x = int64_t(1) << 30;
+    int64_t y = 0;
+    for (int i = 0; i < int(sizeof(CORDIC_ATAN_Q30) / sizeof(CORDIC_ATAN_Q30[0])); i++)
+    {
+        int64_t nx = angle >= 0 ? x - (y >> i) : x + (y >> i);
+        int64_t ny = angle >= 0 ? y + (x >> i) : y - (x >> i);
+        angle += angle >= 0 ? -CORDIC_ATAN_Q30[i] : CORDIC_ATAN_Q30[i];
+        x = nx;
+        y = ny;
+    }
+    return (y << 30) / x;
+}
+
 GalvoSimulator::GalvoSimulator(float maxAngle)
 {
     // galvo physics state
@@ -27,22 +82,93 @@ GalvoSimulator::GalvoSimulator(float maxAngle)
     m_maxAngle = maxAngle;
     scaleFactor = 1.0f;
     frameIndex = 0;
+    holdCount = 0;
+    m_Integrator = Integrator::EULER;
+    m_PropagatorDt = 0.0f;
+    m_Propagator[0][0] = 1.0f;
+    m_Propagator[0][1] = 0.0f;
+    m_Propagator[1][0] = 0.0f;
+    m_Propagator[1][1] = 1.0f;
+
+    m_FixedStiffness = ToFixed(stiffness, 16);
+    m_FixedDamping = ToFixed(damping, 16);
+    m_FixedMaxSpeed = ToFixed(maxSpeed, 16);
+    m_FixedMaxSpeedSq = m_FixedMaxSpeed * m_FixedMaxSpeed;
+    m_FixedToleranceSq = ToFixed(toleranceSq, 32);
     SetMaxAngle(maxAngle);
 }
 
+void GalvoSimulator::SetIntegrator(Integrator integrator)
+{
+    if ((integrator == Integrator::FIXED) != (m_Integrator == Integrator::FIXED))
+    {
+        if (integrator == Integrator::FIXED)
+        {
+            m_FixedAngleX = ToFixed(AngleX, 16);
+            m_FixedAngleY = ToFixed(AngleY, 16);
+            m_FixedVelX = ToFixed(AngularVelX, 16);
+            m_FixedVelY = ToFixed(AngularVelY, 16);
+        }
+        else
+        {
+            AngleX = FromFixed(m_FixedAngleX, 16);
+            AngleY = FromFixed(m_FixedAngleY, 16);
+            AngularVelX = FromFixed(m_FixedVelX, 16);
+            AngularVelY = FromFixed(m_FixedVelY, 16);
+        }
+    }
+    m_Integrator = integrator;
+}
+
 void GalvoSimulator::SetMaxAngle(float newMaxAngle)
 {
     m_maxAngle = newMaxAngle;
     scaleFactor = 1.0f / tan(m_maxAngle * 0.01745329251994f);
+    // The FIXED integrator's own copy of the angle, so it stays in step with the float ones
+    m_FixedMaxAngle = ToFixed(newMaxAngle, 16);
+    m_FixedTanMax = FixedTan(m_FixedMaxAngle);
+    // Table up to twice the max angle squared (corners plus overshoot); beyond it StepFixed
+    // falls back to the CORDIC tangent
+    int64_t radiusSqMax = 4 * m_FixedMaxAngle * m_FixedMaxAngle;
+    m_FixedScaleShift = 0;
+    while ((radiusSqMax >> m_FixedScaleShift) > FIXED_SCALE_ENTRIES)
+        m_FixedScaleShift++;
+    m_FixedScale.resize(FIXED_SCALE_ENTRIES + 2);
+    for (size_t i = 0; i < m_FixedScale.size(); i++)
+        m_FixedScale[i] = int32_t(FixedScreenScaleExact(int64_t(i) << m_FixedScaleShift));
 }
 
 void GalvoSimulator::Simulate(const LaserFrame& frame, float dt)
 {
-    simFrame.clear();
+    PROFILE_SCOPE("Simulate");
+    m_FramePolicy.Prepare(simFrame);
     frameIndex = 0;
+    holdCount = 0;
+    if (m_Integrator == Integrator::FIXED)
+    {
+        int64_t fixedDt = ToFixed(dt, 32);
+        while (StepFixed(frame, fixedDt));
+        return;
+    }
     while(Step(frame, dt));
 }
 
+void GalvoSimulator::SetFrameMemory(std::pmr::memory_resource* resource)
+{
+    SimFrame frame(resource ? resource : std::pmr::get_default_resource());
+    frame.reserve(simFrame.capacity());
+    frame.assign(simFrame.begin(), simFrame.end());
+    // pmr containers never propagate their resource on assignment or swap, so rebuild in place
+    std::destroy_at(&simFrame);
+    std::construct_at(&simFrame, std::move(frame));
+}
+
+void GalvoSimulator::SimulateMany(std::vector<GalvoSimulator>& simulators, const std::vector<const LaserFrame*>& frames, float dt, ThreadPool& pool)
+{
+    size_t count = std::min(simulators.size(), frames.size());
+    pool.ParallelFor(count, [&] (size_t i) { simulators[i].Simulate(*frames[i], dt); });
+}
+
 bool GalvoSimulator::Step(const LaserFrame& frame, float dt)
 {
     if (frame.empty())
@@ -67,6 +193,100 @@ bool GalvoSimulator::Step(const LaserFrame& frame, float dt)
     float dx = txa - AngleX;
     float dy = tya - AngleY;
 
+    if (m_Integrator == Integrator::EXACT)
+        IntegrateExact(dx, dy, dt);
+    else
+        IntegrateEuler(dx, dy, dt);
+
+    CalcScreenPositions();
+    simFrame.push_back({ screenX, screenY, target.r, target.g, target.b, target.flags});
+
+    // advance to next target point
+    if (dx * dx + dy * dy < toleranceSq)
+    {
+        if (++holdCount > 2) 
+        { 
+            frameIndex++; 
+            holdCount = 0;
+        }
+    }
+    return frameIndex < frame.size();
+}
+
+// Step and IntegrateEuler in integer arithmetic: Q16 angles and velocities, dt in
+// Q32 seconds (products stay within int64 for dt up to a quarter second). Right
+// shifts floor and divisions truncate, as C++20 defines them, so every platform
+// gets the same bits. Screen positions come from a CORDIC tangent instead of
+// sqrt/atan2/tan/cos/sin: screen = tan(r) / tan(maxAngle) * angle / r, with the
+// scale tabulated over r^2 at construction.
+bool GalvoSimulator::StepFixed(const LaserFrame& frame, int64_t dt)
+{
+    if (frame.empty())
+        return false;
+    const LaserPoint& target = frame[frameIndex];
+    int64_t tx = std::clamp((int64_t(target.x) * m_FixedMaxAngle) >> 15, -m_FixedMaxAngle, m_FixedMaxAngle);
+    int64_t ty = std::clamp((int64_t(target.y) * m_FixedMaxAngle) >> 15, -m_FixedMaxAngle, m_FixedMaxAngle);
+    int64_t dx = tx - m_FixedAngleX;
+    int64_t dy = ty - m_FixedAngleY;
+
+    int64_t ax = (m_FixedStiffness * dx - m_FixedDamping * m_FixedVelX) >> 16;
+    int64_t ay = (m_FixedStiffness * dy - m_FixedDamping * m_FixedVelY) >> 16;
+    m_FixedVelX += (ax * dt) >> 32;
+    m_FixedVelY += (ay * dt) >> 32;
+    int64_t speedSq = m_FixedVelX * m_FixedVelX + m_FixedVelY * m_FixedVelY;
+    if (speedSq > m_FixedMaxSpeedSq)
+    {
+        int64_t speed = FloorSqrt(speedSq);
+        m_FixedVelX = m_FixedVelX * m_FixedMaxSpeed / speed;
+        m_FixedVelY = m_FixedVelY * m_FixedMaxSpeed / speed;
+    }
+    m_FixedAngleX += (m_FixedVelX * dt) >> 32;
+    m_FixedAngleY += (m_FixedVelY * dt) >> 32;
+
+    // Screen position in Q24
+    int64_t scale = FixedScreenScale(m_FixedAngleX * m_FixedAngleX + m_FixedAngleY * m_FixedAngleY);
+    int64_t sx = (m_FixedAngleX * scale) >> 24;
+    int64_t sy = (m_FixedAngleY * scale) >> 24;
+    simFrame.push_back({ FromFixed(sx, 24), FromFixed(sy, 24), target.r, target.g, target.b, target.flags });
+
+    if (dx * dx + dy * dy < m_FixedToleranceSq)
+    {
+        if (++holdCount > 2)
+        {
+            frameIndex++;
+            holdCount = 0;
+        }
+    }
+    return frameIndex < frame.size();
+}
+
+// Interpolated from the table: the scale is smooth in r^2, so neither a square root
+// nor a division is needed per step
+int64_t GalvoSimulator::FixedScreenScale(int64_t radiusSq) const
+{
+    int64_t index = radiusSq >> m_FixedScaleShift;
+    if (index >= FIXED_SCALE_ENTRIES)
+        return FixedScreenScaleExact(radiusSq);
+    int64_t fraction = radiusSq & ((int64_t(1) << m_FixedScaleShift) - 1);
+    int64_t a = m_FixedScale[size_t(index)];
+    int64_t b = m_FixedScale[size_t(index) + 1];
+    return a + (((b - a) * fraction) >> m_FixedScaleShift);
+}
+
+int64_t GalvoSimulator::FixedScreenScaleExact(int64_t radiusSq) const
+{
+    int64_t r = FloorSqrt(radiusSq);
+    if (r == 0)
+    {
+        // Limit at the center: tan(r) / r is the radians per degree
+        return (DEG_TO_RAD_Q30 << 32) / m_FixedTanMax;
+    }
+    int64_t ratio = (FixedTan(r) << 24) / m_FixedTanMax;
+    return (ratio << 24) / r;
+}
+
+void GalvoSimulator::IntegrateEuler(float dx, float dy, float dt)
+{
     float ax = stiffness * dx - damping * AngularVelX;
     float ay = stiffness * dy - damping * AngularVelY;
 
@@ -84,21 +304,77 @@ bool GalvoSimulator::Step(const LaserFrame& frame, float dt)
 
     AngleX += AngularVelX * dt;
     AngleY += AngularVelY * dt;
+}
 
-    CalcScreenPositions();
-    simFrame.push_back({ screenX, screenY, target.r, target.g, target.b, target.flags});
+void GalvoSimulator::IntegrateExact(float dx, float dy, float dt)
+{
+    if (dt != m_PropagatorDt)
+        UpdatePropagator(dt);
 
-    // advance to next target point
-    static int hold = 0;
-    if (dx * dx + dy * dy < toleranceSq)
+    // Error state e = angle - target follows e'' = -stiffness * e - damping * e',
+    // so one step is a 2x2 matrix applied per axis
+    const float (&P)[2][2] = m_Propagator;
+    float velX = P[1][0] * -dx + P[1][1] * AngularVelX;
+    float velY = P[1][0] * -dy + P[1][1] * AngularVelY;
+    if (velX * velX + velY * velY > maxSpeed * maxSpeed)
     {
-        if (++hold > 2) 
-        { 
-            frameIndex++; 
-            hold = 0;
-        }
+        // Speed limited: the linear solution no longer applies
+        IntegrateEuler(dx, dy, dt);
+        return;
     }
-    return frameIndex < frame.size();
+    float errX = P[0][0] * -dx + P[0][1] * AngularVelX;
+    float errY = P[0][0] * -dy + P[0][1] * AngularVelY;
+    AngleX += dx + errX;
+    AngleY += dy + errY;
+    AngularVelX = velX;
+    AngularVelY = velY;
+}
+
+void GalvoSimulator::UpdatePropagator(float dt)
+{
+    // exp(A * dt) by scaling and squaring a Taylor series, in double
+    double a[2][2] = { { 0.0, double(dt) }, { -double(stiffness) * dt, -double(damping) * dt } };
+    double norm = std::max(std::abs(a[0][0]) + std::abs(a[0][1]), std::abs(a[1][0]) + std::abs(a[1][1]));
+    int squarings = 0;
+    while (norm > 0.5)
+    {
+        norm *= 0.5;
+        squarings++;
+    }
+    double scale = std::ldexp(1.0, -squarings);
+    for (auto& row : a)
+        for (double& v : row)
+            v *= scale;
+
+    double result[2][2] = { { 1.0, 0.0 }, { 0.0, 1.0 } };
+    double term[2][2] = { { 1.0, 0.0 }, { 0.0, 1.0 } };
+    for (int n = 1; n <= 12; n++)
+    {
+        double next[2][2];
+        for (int r = 0; r < 2; r++)
+            for (int c = 0; c < 2; c++)
+                next[r][c] = (term[r][0] * a[0][c] + term[r][1] * a[1][c]) / n;
+        for (int r = 0; r < 2; r++)
+            for (int c = 0; c < 2; c++)
+            {
+                term[r][c] = next[r][c];
+                result[r][c] += next[r][c];
+            }
+    }
+    for (int i = 0; i < squarings; i++)
+    {
+        double sq[2][2];
+        for (int r = 0; r < 2; r++)
+            for (int c = 0; c < 2; c++)
+                sq[r][c] = result[r][0] * result[0][c] + result[r][1] * result[1][c];
+        for (int r = 0; r < 2; r++)
+            for (int c = 0; c < 2; c++)
+                result[r][c] = sq[r][c];
+    }
+    for (int r = 0; r < 2; r++)
+        for (int c = 0; c < 2; c++)
+            m_Propagator[r][c] = float(result[r][c]);
+    m_PropagatorDt = dt;
 }
 
 float GalvoSimulator::ConvertAngle(const int16_t angle) const
@@ -1,7 +1,11 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <memory_resource>
 #include "LaserFrameGenerator.h"
+#include "FrameBuffer.h"
+
+class ThreadPool;
 
 struct SimPoint
 {
@@ -11,21 +15,44 @@ struct SimPoint
     uint8_t flags; // 1 = laser on, 0 = blank
 };
 
-using SimFrame = std::vector<SimPoint>;
+using SimFrame = std::pmr::vector<SimPoint>;
 
 class GalvoSimulator
 {
 public:
+    enum class Integrator
+    {
+        EULER, // explicit Euler, the reference model
+        EXACT, // closed-form spring-damper step, Euler only while the speed clamp is active
+        FIXED  // Euler in integer fixed point, bit-identical on every platform and compiler
+    };
     GalvoSimulator(float maxAngle);
+    // Switching to or from FIXED carries the galvo state across, rounded to the new representation
+    void SetIntegrator(Integrator integrator);
+    Integrator GetIntegrator() const { return m_Integrator; }
     void Simulate(const LaserFrame& frame, float dt);
 	SimFrame& GetSimFrame() { return simFrame; }
+    FrameBufferPolicy& GetFramePolicy() { return m_FramePolicy; }
+    // Moves the sim frame onto the given resource (e.g. a FrameArena); nullptr returns to the heap.
+    // Copies of a simulator always get a heap-backed SimFrame.
+    void SetFrameMemory(std::pmr::memory_resource* resource);
+    // Runs simulators[i].Simulate(*frames[i], dt) for every projector head across the pool.
+    // Each simulator only touches its own state and SimFrame, so the result matches a serial loop.
+    static void SimulateMany(std::vector<GalvoSimulator>& simulators, const std::vector<const LaserFrame*>& frames, float dt, ThreadPool& pool);
 private:
     void SetMaxAngle(float newMaxAngle);
     bool Step(const LaserFrame& frame, float dt);
+    void IntegrateEuler(float dx, float dy, float dt);
+    void IntegrateExact(float dx, float dy, float dt);
+    void UpdatePropagator(float dt);
+    bool StepFixed(const LaserFrame& frame, int64_t dt);
+    int64_t FixedScreenScale(int64_t radiusSq) const;
+    int64_t FixedScreenScaleExact(int64_t radiusSq) const;
     float ConvertAngle(const int16_t angle) const;
     void CalcScreenPositions();
     // physical properties (tunable)
     SimFrame simFrame;
+    FrameBufferPolicy m_FramePolicy;
     float damping;
     float stiffness;
     float maxSpeed;
@@ -38,4 +65,21 @@ private:
     float screenX;
     float screenY;
     size_t frameIndex;
+    int holdCount; // steps spent inside tolerance of the current target
+    Integrator m_Integrator;
+    // exp(A * dt) for A = [0 1; -stiffness -damping], cached per dt
+    float m_PropagatorDt;
+    float m_Propagator[2][2];
+    // FIXED state and constants: angles in Q16 degrees, velocities in Q16 degrees per second,
+    // squares in Q32, tangents in Q30. Kept in int64 so products never overflow.
+    int64_t m_FixedAngleX = 0, m_FixedAngleY = 0;
+    int64_t m_FixedVelX = 0, m_FixedVelY = 0;
+    int64_t m_FixedStiffness, m_FixedDamping;
+    int64_t m_FixedMaxSpeed, m_FixedMaxSpeedSq;
+    int64_t m_FixedToleranceSq;
+    int64_t m_FixedMaxAngle;
+    int64_t m_FixedTanMax;
+    // tan(r) / (r * tan(maxAngle)) per degree in Q32, sampled every 2^m_FixedScaleShift of r^2
+    std::vector<int32_t> m_FixedScale;
+    int m_FixedScaleShift;
 };
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "GoldenFrames.h"
+
+// Golden-frame tool: records the canned scenes to a golden file, or renders
+// them again and compares against one. check exits with 1 if any scene is
+// outside the tolerances, so it can gate a change to the generator or
+// simulator. Record with the default (reference) paths, then check a fast
+// path with the options that select it and tolerances that suit it.
+
+struct Options
+{
+    std::string command;
+    std::string path;
+    GoldenSettings settings;
+    GoldenTolerance tolerance;
+};
+
+static void PrintUsage()
+{
+    std::printf(
+        "usage: laser_golden record FILE [paths]\n"
+        "       laser_golden check FILE [paths] [tolerances]\n"
+        "paths (default: exact correction, exact HSV color, no templates, exact poses, Euler):\n"
+        "  --lut              LUT distortion correction\n"
+        "  --color-tables     baked color tables\n"
+        "  --templates        cached Square/Ship tessellations\n"
+        "  --pose-table       interpolated Linkage poses\n"
+        "  --exact            closed-form galvo integrator\n"
+        "  --fixed            fixed-point galvo integrator\n"
+        "  --steps N          galvo sim steps per frame, dt = 1/N (500)\n"
+        "tolerances (default: exact match):\n"
+        "  --position N       laser position, DAC units per axis\n"
+        "  --color N          color levels per channel\n"
+        "  --count N          laser point count difference\n"
+        "  --sim-position F   simulated position, screen units per axis\n"
+        "  --sim-count N      sim step count difference\n");
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options)
+{
+    if (argc < 3)
+        return false;
+    options.command = argv[1];
+    options.path = argv[2];
+    if (options.command != "record" && options.command != "check")
+        return false;
+    for (int i = 3; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--lut")
+            options.settings.correction = DistortionCorrector::Mode::LUT;
+        else if (arg == "--color-tables")
+            options.settings.colorTables = true;
+        else if (arg == "--templates")
+            options.settings.shapeTemplates = true;
+        else if (arg == "--pose-table")
+            options.settings.linkagePoseTable = true;
+        else if (arg == "--exact")
+            options.settings.integrator = GalvoSimulator::Integrator::EXACT;
+        else if (arg == "--fixed")
+            options.settings.integrator = GalvoSimulator::Integrator::FIXED;
+        else if (arg == "--steps" && hasValue)
+            options.settings.simDt = 1.0f / float(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--position" && hasValue)
+            options.tolerance.position = std::atoi(argv[++i]);
+        else if (arg == "--color" && hasValue)
+            options.tolerance.color = std::atoi(argv[++i]);
+        else if (arg == "--count" && hasValue)
+            options.tolerance.pointCount = std::atoi(argv[++i]);
+        else if (arg == "--sim-position" && hasValue)
+            options.tolerance.simPosition = float(std::atof(argv[++i]));
+        else if (arg == "--sim-count" && hasValue)
+            options.tolerance.simPointCount = std::atoi(argv[++i]);
+        else
+            return false;
+    }
+    return true;
+}
+
+static int Check(const Options& options)
+{
+    std::vector<GoldenScene> golden = ReadGoldenFile(options.path);
+    std::vector<GoldenScene> actual = RenderGoldenScenes(options.settings);
+    int failed = 0;
+    std::printf("%-14s %8s %8s %8s %6s %10s %8s  %s\n", "scene", "pos", "color", "count", "flags", "sim pos", "sim cnt", "result");
+    auto report = [&] (const GoldenDiff& diff)
+    {
+        bool ok = diff.Within(options.tolerance);
+        failed += ok ? 0 : 1;
+        if (diff.missing)
+        {
+            std::printf("%-14s %63s  FAIL (missing)\n", diff.name.c_str(), "");
+            return;
+        }
+        std::printf("%-14s %8d %8d %+8d %6d %10.6f %+8d  %s", diff.name.c_str(), diff.maxPositionError, diff.maxColorError,
+            diff.pointCountDelta, diff.flagMismatches, diff.maxSimPositionError, diff.simPointCountDelta, ok ? "ok" : "FAIL");
+        if (diff.firstMismatch >= 0)
+            std::printf(" (first at point %d)", diff.firstMismatch);
+        std::printf("\n");
+    };
+    for (const GoldenScene& g : golden)
+    {
+        auto match = std::find_if(actual.begin(), actual.end(), [&g] (const GoldenScene& a) { return a.name == g.name; });
+        if (match == actual.end())
+        {
+            GoldenDiff diff;
+            diff.name = g.name;
+            diff.missing = true;
+            report(diff);
+            continue;
+        }
+        report(DiffGoldenScene(g, *match, options.tolerance));
+    }
+    // Scenes added since the file was recorded have nothing to compare against
+    for (const GoldenScene& a : actual)
+    {
+        auto same = [&a] (const GoldenScene& g) { return g.name == a.name; };
+        if (std::none_of(golden.begin(), golden.end(), same))
+        {
+            GoldenDiff diff;
+            diff.name = a.name;
+            diff.missing = true;
+            report(diff);
+        }
+    }
+    std::printf("%d of %zu scenes failed\n", failed, std::max(golden.size(), actual.size()));
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+    try
+    {
+        if (options.command == "check")
+            return Check(options);
+        std::vector<GoldenScene> scenes = RenderGoldenScenes(options.settings);
+        WriteGoldenFile(options.path, scenes);
+        for (const GoldenScene& scene : scenes)
+            std::printf("%-14s %6zu laser points %7zu sim points\n", scene.name.c_str(), scene.laser.size(), scene.sim.size());
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "GoldenFrames.h"
+#include "Matrix3X3.h"
+#include "Shapes.h"
+
+static constexpr float PI = 3.14159265358979323846f;
+static constexpr float PI2 = 2.0f * PI;
+static constexpr float MAX_ANGLE = 35.0f;
+static constexpr uint32_t GOLDEN_VERSION = 1;
+static constexpr size_t LASER_RECORD_SIZE = 8;
+static constexpr size_t SIM_RECORD_SIZE = 12;
+
+bool GoldenDiff::Within(const GoldenTolerance& tolerance) const
+{
+    return !missing && flagMismatches == 0 &&
+        maxPositionError <= tolerance.position &&
+        maxColorError <= tolerance.color &&
+        std::abs(pointCountDelta) <= tolerance.pointCount &&
+        maxSimPositionError <= tolerance.simPosition &&
+        std::abs(simPointCountDelta) <= tolerance.simPointCount;
+}
+
+std::vector<GoldenScene> RenderGoldenScenes(const GoldenSettings& settings)
+{
+    using Draw = std::function<void(ShapeGenerator&, const Linkage&)>;
+    struct SceneSpec
+    {
+        std::string name;
+        Draw draw;
+    };
+    LaserColor white(0.0f, 0.0f, 1.0f);
+    LaserColor redgreen(LaserColor::RGB8 { 255, 0, 0 }, LaserColor::RGB8 { 0, 255, 0 });
+    LaserColor hueWheel(0.0f, 359.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+    Mat3 linkageMatrix = Mat3::Translation(0.5f, -0.5f) * Mat3::Scale(0.1f, 0.1f);
+
+    std::vector<SceneSpec> specs;
+    specs.push_back({ "square", [=] (ShapeGenerator& shapes, const Linkage&)
+        { shapes.Square(Mat3::Translation(0.2f, -0.1f) * Mat3::Rotation(0.3f) * Mat3::Scale(0.4f, 0.4f), redgreen); } });
+    specs.push_back({ "ship", [=] (ShapeGenerator& shapes, const Linkage&)
+        { shapes.Ship(Mat3::Translation(-0.2f, 0.3f) * Mat3::Rotation(1.0f) * Mat3::Scale(3.0f, 3.0f), white); } });
+    specs.push_back({ "smooth_square", [=] (ShapeGenerator& shapes, const Linkage&)
+        { shapes.SmoothSquare(Point2D(0.1f, 0.1f), 0.8f, hueWheel); } });
+    specs.push_back({ "arc_test", [=] (ShapeGenerator& shapes, const Linkage&)
+        { shapes.ArcTest(Point2D(-0.3f, 0.2f), 0.6f, redgreen); } });
+    // DrawLinkage takes angles in [-2pi, 0] and traces the coupler curve up to that point
+    for (int degrees = 60; degrees <= 360; degrees += 60)
+    {
+        float angle = -PI2 + PI2 * float(degrees) / 360.0f;
+        specs.push_back({ "linkage_" + std::to_string(degrees), [=] (ShapeGenerator&, const Linkage& linkage)
+            { linkage.DrawLinkage(linkageMatrix, angle, white); } });
+    }
+    // Everything at once, as the headless driver draws it
+    specs.push_back({ "scene", [=] (ShapeGenerator& shapes, const Linkage& linkage)
+    {
+        shapes.Ship(Mat3::Identity(), white);
+        for (int i = 0; i < 64; i++)
+        {
+            float a = PI2 * float(i) / 64.0f;
+            float r = 0.3f + 0.5f * float(i % 8) / 8.0f;
+            shapes.Square(Mat3::Translation(std::cos(a) * r, std::sin(a) * r) * Mat3::Rotation(a) * Mat3::Scale(0.01f, 0.01f), redgreen);
+        }
+        shapes.ArcTest(Point2D(-0.6f, 0.6f), 0.3f, redgreen);
+        linkage.DrawLinkage(linkageMatrix, -PI2 * 0.25f, white);
+    } });
+
+    std::vector<GoldenScene> scenes;
+    scenes.reserve(specs.size());
+    for (const SceneSpec& spec : specs)
+    {
+        // Fresh generator and galvo per scene, so every scene starts from the origin
+        LaserFrameGenerator generator(0.9f, MAX_ANGLE);
+        generator.SetCorrectionMode(settings.correction);
+        generator.SetColorTables(settings.colorTables);
+        ShapeGenerator shapes(generator);
+        shapes.SetShapeTemplates(settings.shapeTemplates);
+        Linkage linkage(generator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+        linkage.SetPoseTable(settings.linkagePoseTable);
+        GalvoSimulator simulator(MAX_ANGLE);
+        simulator.SetIntegrator(settings.integrator);
+
+        generator.NewFrame();
+        spec.draw(shapes, linkage);
+        generator.EndFrame();
+        simulator.Simulate(generator.GetLaserFrame(), settings.simDt);
+
+        GoldenScene& scene = scenes.emplace_back();
+        scene.name = spec.name;
+        scene.laser.assign(generator.GetLaserFrame().begin(), generator.GetLaserFrame().end());
+        scene.sim.assign(simulator.GetSimFrame().begin(), simulator.GetSimFrame().end());
+    }
+    return scenes;
+}
+
+static void PutU16(std::vector<uint8_t>& out, uint16_t v)
+{
+    out.push_back(uint8_t(v));
+    out.push_back(uint8_t(v >> 8));
+}
+
+static void PutU32(std::vector<uint8_t>& out, uint32_t v)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+        out.push_back(uint8_t(v >> shift));
+}
+
+static void PutF32(std::vector<uint8_t>& out, float v)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    PutU32(out, bits);
+}
+
+void WriteGoldenFile(const std::string& path, const std::vector<GoldenScene>& scenes)
+{
+    std::vector<uint8_t> out;
+    out.insert(out.end(), { 'L', 'G', 'L', 'D' });
+    PutU32(out, GOLDEN_VERSION);
+    PutU32(out, uint32_t(scenes.size()));
+    for (const GoldenScene& scene : scenes)
+    {
+        PutU16(out, uint16_t(scene.name.size()));
+        out.insert(out.end(), scene.name.begin(), scene.name.end());
+        PutU32(out, uint32_t(scene.laser.size()));
+        PutU32(out, uint32_t(scene.sim.size()));
+        for (const LaserPoint& p : scene.laser)
+        {
+            PutU16(out, uint16_t(p.x));
+            PutU16(out, uint16_t(p.y));
+            out.insert(out.end(), { p.r, p.g, p.b, p.flags });
+        }
+        for (const SimPoint& p : scene.sim)
+        {
+            PutF32(out, p.x);
+            PutF32(out, p.y);
+            out.insert(out.end(), { p.r, p.g, p.b, p.flags });
+        }
+    }
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("Failed to create golden file " + path);
+    size_t written = std::fwrite(out.data(), 1, out.size(), file);
+    if (std::fclose(file) != 0 || written != out.size())
+        throw std::runtime_error("Failed to write golden file " + path);
+}
+
+// Bounds-checked little-endian reads over the loaded file
+class GoldenParser
+{
+public:
+    GoldenParser(const std::vector<uint8_t>& data, const std::string& path) : m_Data(data), m_Path(path) {}
+    const uint8_t* Take(size_t size)
+    {
+        if (m_Data.size() - m_Offset < size)
+            throw std::runtime_error("Truncated golden file " + m_Path);
+        const uint8_t* p = m_Data.data() + m_Offset;
+        m_Offset += size;
+        return p;
+    }
+    uint16_t U16()
+    {
+        const uint8_t* p = Take(2);
+        return uint16_t(p[0] | (p[1] << 8));
+    }
+    uint32_t U32()
+    {
+        const uint8_t* p = Take(4);
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+    float F32()
+    {
+        uint32_t bits = U32();
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    size_t Remaining() const { return m_Data.size() - m_Offset; }
+private:
+    const std::vector<uint8_t>& m_Data;
+    const std::string& m_Path;
+    size_t m_Offset = 0;
+};
+
+std::vector<GoldenScene> ReadGoldenFile(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        throw std::runtime_error("Failed to open golden file " + path);
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + read);
+    std::fclose(file);
+
+    GoldenParser parser(data, path);
+    if (std::memcmp(parser.Take(4), "LGLD", 4) != 0)
+        throw std::runtime_error("Not a golden file: " + path);
+    uint32_t version = parser.U32();
+    if (version != GOLDEN_VERSION)
+        throw std::runtime_error("Unsupported golden file version " + std::to_string(version) + " in " + path);
+    uint32_t count = parser.U32();
+    std::vector<GoldenScene> scenes;
+    for (uint32_t s = 0; s < count; s++)
+    {
+        GoldenScene& scene = scenes.emplace_back();
+        uint16_t nameLength = parser.U16();
+        const uint8_t* name = parser.Take(nameLength);
+        scene.name.assign(name, name + nameLength);
+        uint32_t laserPoints = parser.U32();
+        uint32_t simPoints = parser.U32();
+        // Check the sizes before resizing so a corrupt count cannot ask for gigabytes
+        if (parser.Remaining() < size_t(laserPoints) * LASER_RECORD_SIZE + size_t(simPoints) * SIM_RECORD_SIZE)
+            throw std::runtime_error("Truncated golden file " + path);
+        scene.laser.resize(laserPoints);
+        for (LaserPoint& p : scene.laser)
+        {
+            p.x = int16_t(parser.U16());
+            p.y = int16_t(parser.U16());
+            const uint8_t* rgbf = parser.Take(4);
+            p.r = rgbf[0];
+            p.g = rgbf[1];
+            p.b = rgbf[2];
+            p.flags = rgbf[3];
+        }
+        scene.sim.resize(simPoints);
+        for (SimPoint& p : scene.sim)
+        {
+            p.x = parser.F32();
+            p.y = parser.F32();
+            const uint8_t* rgbf = parser.Take(4);
+            p.r = rgbf[0];
+            p.g = rgbf[1];
+            p.b = rgbf[2];
+            p.flags = rgbf[3];
+        }
+    }
+    return scenes;
+}
+
+GoldenDiff DiffGoldenScene(const GoldenScene& golden, const GoldenScene& actual, const GoldenTolerance& tolerance)
+{
+    GoldenDiff diff;
+    diff.name = golden.name;
+    diff.pointCountDelta = int(actual.laser.size()) - int(golden.laser.size());
+    diff.simPointCountDelta = int(actual.sim.size()) - int(golden.sim.size());
+    // A point gained or lost early shifts every later index, so each point is matched
+    // against the golden points within the count difference of its own index
+    const int laserWindow = std::abs(diff.pointCountDelta);
+    const int goldenPoints = int(golden.laser.size());
+    for (int i = 0; i < int(actual.laser.size()); i++)
+    {
+        const LaserPoint& a = actual.laser[i];
+        int first = std::max(0, i - laserWindow);
+        int last = std::min(goldenPoints - 1, i + laserWindow);
+        if (first > last)
+            continue;
+        int position = INT_MAX;
+        int color = 0;
+        bool flags = false;
+        // Same index first, so ties (a blank dwell and the lit point after it) keep the aligned match
+        for (int k = first - 1; k <= last; k++)
+        {
+            int j = (k < first) ? std::min(i, last) : k;
+            const LaserPoint& g = golden.laser[j];
+            int p = std::max(std::abs(a.x - g.x), std::abs(a.y - g.y));
+            if (p < position)
+            {
+                position = p;
+                color = std::max({ std::abs(a.r - g.r), std::abs(a.g - g.g), std::abs(a.b - g.b) });
+                flags = (a.flags != 0) != (g.flags != 0);
+            }
+        }
+        diff.maxPositionError = std::max(diff.maxPositionError, position);
+        diff.maxColorError = std::max(diff.maxColorError, color);
+        diff.flagMismatches += flags ? 1 : 0;
+        if (diff.firstMismatch < 0 && (flags || position > tolerance.position || color > tolerance.color))
+            diff.firstMismatch = i;
+    }
+    const int simWindow = std::abs(diff.simPointCountDelta);
+    const int goldenSimPoints = int(golden.sim.size());
+    for (int i = 0; i < int(actual.sim.size()); i++)
+    {
+        int first = std::max(0, i - simWindow);
+        int last = std::min(goldenSimPoints - 1, i + simWindow);
+        if (first > last)
+            continue;
+        float error = FLT_MAX;
+        for (int j = first; j <= last; j++)
+            error = std::min(error, std::max(std::abs(actual.sim[i].x - golden.sim[j].x), std::abs(actual.sim[i].y - golden.sim[j].y)));
+        diff.maxSimPositionError = std::max(diff.maxSimPositionError, error);
+    }
+    return diff;
+}
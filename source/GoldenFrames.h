@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GalvoSimulator.h"
+#include "LaserFrameGenerator.h"
+
+// Golden-frame regression data. A fixed set of scenes is drawn through
+// ShapeGenerator and simulated, and the LaserFrame and SimFrame of each are
+// stored in a small binary file (little endian):
+//   "LGLD" u32 version u32 sceneCount, then per scene
+//   u16 nameLength, name, u32 laserPoints, u32 simPoints,
+//   laser points as i16 x, i16 y, u8 r, g, b, flags (8 bytes),
+//   sim points as f32 x, f32 y, u8 r, g, b, flags (12 bytes).
+// Recording with the reference paths (exact correction, exact HSV color, no
+// shape templates, exact linkage poses, Euler integrator) and comparing a build or mode against the
+// file shows how far a fast path strays from the reference.
+
+struct GoldenScene
+{
+    std::string name;
+    LaserFrame laser;
+    SimFrame sim;
+};
+
+// Which generator and simulator paths render the scenes
+struct GoldenSettings
+{
+    DistortionCorrector::Mode correction = DistortionCorrector::Mode::EXACT;
+    bool colorTables = false;
+    bool shapeTemplates = false;
+    bool linkagePoseTable = false;
+    GalvoSimulator::Integrator integrator = GalvoSimulator::Integrator::EULER;
+    float simDt = 1.0f / 500.0f;
+};
+
+// Largest differences allowed per field; the defaults demand an exact match
+struct GoldenTolerance
+{
+    int position = 0;         // DAC units, per axis
+    int color = 0;            // levels, per channel
+    int pointCount = 0;       // laser points
+    float simPosition = 0.0f; // normalized screen units, per axis
+    int simPointCount = 0;
+};
+
+struct GoldenDiff
+{
+    std::string name;
+    int maxPositionError = 0;
+    int maxColorError = 0;
+    int pointCountDelta = 0;    // actual minus golden
+    int flagMismatches = 0;     // blanking differs; never tolerated
+    float maxSimPositionError = 0.0f;
+    int simPointCountDelta = 0;
+    int firstMismatch = -1;     // first laser point outside tolerance, -1 if none
+    bool missing = false;       // scene absent from one side
+    bool Within(const GoldenTolerance& tolerance) const;
+};
+
+// Renders the canned scenes: Square, Ship, SmoothSquare, ArcTest, Linkage at several angles, and the full headless scene
+std::vector<GoldenScene> RenderGoldenScenes(const GoldenSettings& settings);
+// Both throw std::runtime_error on I/O errors or a malformed file
+void WriteGoldenFile(const std::string& path, const std::vector<GoldenScene>& scenes);
+std::vector<GoldenScene> ReadGoldenFile(const std::string& path);
+// Points are compared index by index. When the counts differ, each point is matched
+// to the closest golden point within the count difference of its index.
+GoldenDiff DiffGoldenScene(const GoldenScene& golden, const GoldenScene& actual, const GoldenTolerance& tolerance);
@@ -0,0 +1,1145 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "AllocationCounter.h"
+#include "GalvoSimulator.h"
+#include "LaserFrameGenerator.h"
+#include "LaserColor.h"
+#include "Shapes.h"
+#include "Point2D.h"
+#include "Matrix3X3.h"
+#include "ThreadPool.h"
+#include "Ilda.h"
+#include "Idn.h"
+#include "DacPlayback.h"
+#include "PathOptimizer.h"
+#include "PointKernel.h"
+#include "Object.h"
+#include "SpatialHash.h"
+#include "FramePipeline.h"
+#include "FixedStepClock.h"
+#include "Profiler.h"
+#include "SoftwareRenderer.h"
+
+// Headless driver: generates and simulates frames without a window and
+// reports throughput. Runs anywhere laser_core builds.
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr float PI = 3.14159265358979323846f;
+static constexpr float PI2 = 2.0f * PI;
+
+struct Options
+{
+    int frames = 600;
+    int heads = 1;
+    int threads = 0;
+    int bullets = 256;
+    float fps = 60.0f;
+    float simstepsPerSecond = 30000.0f;
+    bool lut = false;
+    bool exact = false;
+    bool fixed = false;
+    bool optimize = false;
+    bool templates = true;
+    float pps = 0.0f;
+    bool colorBench = false;
+    bool poolBench = false;
+    bool collisionBench = false;
+    bool checkParallel = false;
+    bool checkAllocations = false;
+    bool checkFrameGrowth = false;
+    std::string checkIldaPath;
+    std::string checkProfilePath;
+    int pipelineDepth = 0;
+    float cap = 0.0f;
+    std::string profilePath;
+    std::string ildaPath;
+    std::string renderPrefix;
+    int renderWidth = 1920;
+    int renderHeight = 1080;
+    float persistenceMs = 20.0f;
+    std::string idnHost;
+    uint16_t idnPort = IDN_PORT;
+    bool idnLoopback = false;
+    float idnPps = 0.0f;
+    bool idnPace = true;
+    std::string dacSink;
+    float dacPps = 0.0f;
+    bool dacPark = false;
+};
+
+static void PrintUsage()
+{
+    std::printf(
+        "usage: laser_headless [options]\n"
+        "  --frames N     frames to generate and simulate (600)\n"
+        "  --bullets N    bullet squares per frame (256)\n"
+        "  --heads N      projector heads simulated per frame (1)\n"
+        "  --threads N    worker threads for multiple heads (hardware)\n"
+        "  --lut          LUT distortion correction\n"
+        "  --exact        closed-form galvo integrator\n"
+        "  --fixed        fixed-point galvo integrator, bit-identical across platforms\n"
+        "  --optimize     reorder shapes to minimize blank travel\n"
+        "  --no-templates tessellate every Square and Ship instead of replaying cached templates\n"
+        "  --pps N        fit every frame into a budget of N points per second\n"
+        "  --pipeline N   simulate on a pipeline thread with N frames in flight (single head)\n"
+        "  --cap FPS      pace the loop to FPS frames per second and report frame pacing\n"
+        "  --color-bench  time exact vs baked point coloring and check the tables, then exit\n"
+        "  --pool-bench   time AoS vs SoA bullet updates at 256, 4k and 64k entities, then exit\n"
+        "  --collision-bench  time grid vs brute-force bullet/asteroid hits up to 80k entities, then exit\n"
+        "  --check-parallel   check SimulateMany against serial simulation bit for bit, exit 1 on a mismatch\n"
+        "  --check-allocations  count heap allocations in steady-state frames, heap and arena buffers, exit 1 on any\n"
+        "  --check-frame-growth  grow the scene over several frames, exit 1 if a buffer grows mid-frame or keeps regrowing\n"
+        "  --check-ilda FILE  write frames to FILE as ILDA, read them back and compare, exit 1 on a difference\n"
+        "  --check-profile FILE  profile frames into FILE as CSV and check every row has its stage times, exit 1 on a gap\n"
+        "  --ilda FILE    export every generated frame as ILDA format 5\n"
+        "  --idn HOST[:PORT]  stream every frame to an IDN DAC over UDP (port 7255)\n"
+        "  --idn-loopback     stream to a local IDN receiver that simulates the frames instead (not with --render)\n"
+        "  --idn-pps N        IDN scan rate, sets frame durations and pacing (--pps, else 30000)\n"
+        "  --idn-no-pace      send IDN frames as soon as they are generated\n"
+        "  --dac null|FILE    play frames out on a DAC playback thread, discarding the points or writing them to FILE\n"
+        "  --dac-pps N        DAC playback rate (--pps, else 30000)\n"
+        "  --dac-park         park blanked on underrun instead of repeating the last frame\n"
+        "  --render PREFIX  rasterize head 0 on the CPU and write PREFIX00000.ppm, ...\n"
+        "  --render-size WxH  rasterizer resolution (1920x1080)\n"
+        "  --persistence MS   phosphor decay time constant for --render (20)\n"
+        "  --profile FILE record per-stage timings; FILE.json is a Chrome trace, anything else CSV\n");
+}
+
+static bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue)
+            options.frames = std::atoi(argv[++i]);
+        else if (arg == "--bullets" && hasValue)
+            options.bullets = std::atoi(argv[++i]);
+        else if (arg == "--heads" && hasValue)
+            options.heads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue)
+            options.threads = std::atoi(argv[++i]);
+        else if (arg == "--lut")
+            options.lut = true;
+        else if (arg == "--exact")
+            options.exact = true;
+        else if (arg == "--fixed")
+            options.fixed = true;
+        else if (arg == "--optimize")
+            options.optimize = true;
+        else if (arg == "--no-templates")
+            options.templates = false;
+        else if (arg == "--pipeline" && hasValue)
+            options.pipelineDepth = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--cap" && hasValue)
+            options.cap = float(std::atof(argv[++i]));
+        else if (arg == "--pps" && hasValue)
+            options.pps = float(std::atof(argv[++i]));
+        else if (arg == "--color-bench")
+            options.colorBench = true;
+        else if (arg == "--pool-bench")
+            options.poolBench = true;
+        else if (arg == "--collision-bench")
+            options.collisionBench = true;
+        else if (arg == "--check-parallel")
+            options.checkParallel = true;
+        else if (arg == "--check-allocations")
+            options.checkAllocations = true;
+        else if (arg == "--check-frame-growth")
+            options.checkFrameGrowth = true;
+        else if (arg == "--check-ilda" && hasValue)
+            options.checkIldaPath = argv[++i];
+        else if (arg == "--check-profile" && hasValue)
+            options.checkProfilePath = argv[++i];
+        else if (arg == "--profile" && hasValue)
+            options.profilePath = argv[++i];
+        else if (arg == "--ilda" && hasValue)
+            options.ildaPath = argv[++i];
+        else if (arg == "--idn" && hasValue)
+        {
+            std::string_view target = argv[++i];
+            size_t colon = target.rfind(':');
+            options.idnHost = std::string(target.substr(0, colon));
+            if (colon != std::string_view::npos)
+                options.idnPort = uint16_t(std::atoi(argv[i] + colon + 1));
+        }
+        else if (arg == "--idn-loopback")
+            options.idnLoopback = true;
+        else if (arg == "--idn-pps" && hasValue)
+            options.idnPps = float(std::atof(argv[++i]));
+        else if (arg == "--idn-no-pace")
+            options.idnPace = false;
+        else if (arg == "--dac" && hasValue)
+            options.dacSink = argv[++i];
+        else if (arg == "--dac-pps" && hasValue)
+            options.dacPps = float(std::atof(argv[++i]));
+        else if (arg == "--dac-park")
+            options.dacPark = true;
+        else if (arg == "--render" && hasValue)
+            options.renderPrefix = argv[++i];
+        else if (arg == "--render-size" && hasValue)
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &options.renderWidth, &options.renderHeight) != 2 ||
+                options.renderWidth <= 0 || options.renderHeight <= 0)
+                return false;
+        }
+        else if (arg == "--persistence" && hasValue)
+            options.persistenceMs = float(std::atof(argv[++i]));
+        else
+            return false;
+    }
+    return true;
+}
+
+// Ship, a ring of bullets, the arc test and a linkage, all animated by frame number
+static void DrawScene(ShapeGenerator& shapes, const Linkage& linkage, int frame, int bullets, float fps)
+{
+    float time = float(frame) / fps;
+    LaserColor white(0.0f, 0.0f, 1.0f);
+    LaserColor redgreen(LaserColor::RGB8 { 255, 0, 0 }, LaserColor::RGB8 { 0, 255, 0 });
+
+    shapes.Ship(Mat3::Rotation(time), white);
+    for (int i = 0; i < bullets; i++)
+    {
+        float a = PI2 * float(i) / float(bullets) + time * 0.5f;
+        float r = 0.3f + 0.5f * float(i % 8) / 8.0f;
+        Mat3 matrix = Mat3::Translation(std::cos(a) * r, std::sin(a) * r) * Mat3::Rotation(a) * Mat3::Scale(0.01f, 0.01f);
+        shapes.Square(matrix, redgreen);
+    }
+    shapes.ArcTest(Point2D(-0.6f, 0.6f), 0.3f, redgreen);
+    float angle = std::fmod(time * 2.0f, PI2) - PI2;
+    linkage.DrawLinkage(Mat3::Translation(0.5f, -0.5f) * Mat3::Scale(0.1f, 0.1f), angle, white);
+    shapes.Flush();
+}
+
+// Receives IDN frames on a thread and simulates them, timing the arrivals
+class IdnLoopback
+{
+public:
+    IdnLoopback(float maxAngle, float dt) : m_Receiver(0), m_Simulator(maxAngle), m_Dt(dt)
+    {
+        m_Thread = std::thread(&IdnLoopback::Run, this);
+    }
+    uint16_t GetPort() const { return m_Receiver.GetPort(); }
+    // Waits for the frames in flight, then stops
+    void Stop()
+    {
+        m_Stop = true;
+        m_Thread.join();
+    }
+    void Print() const
+    {
+        const IdnReceiver::Stats& stats = m_Receiver.GetStats();
+        double mean = m_Intervals > 0 ? m_IntervalMean * 1000.0 : 0.0;
+        double jitter = m_Intervals > 1 ? std::sqrt(m_IntervalM2 / double(m_Intervals - 1)) * 1000.0 : 0.0;
+        std::printf("idn receive     %zu frames, %zu dropped, %zu packets in %zu calls, %zu lost, %zu malformed\n",
+            stats.framesReceived, stats.framesDropped, stats.packetsReceived, stats.receiveCalls, stats.packetsLost, stats.malformedPackets);
+        std::printf("idn arrivals    %.3f ms mean, %.3f ms jitter, %.3f ms max interval, %zu sim pts\n",
+            mean, jitter, m_IntervalMax * 1000.0, m_SimPoints);
+    }
+private:
+    void Run()
+    {
+        LaserFrame frame;
+        Clock::time_point last;
+        for (;;)
+        {
+            if (!m_Receiver.ReceiveFrame(frame, 100))
+            {
+                if (m_Stop)
+                    return;
+                continue;
+            }
+            Clock::time_point now = Clock::now();
+            if (m_Receiver.GetStats().framesReceived > 1)
+            {
+                // Welford running variance, as FixedStepClock keeps it
+                double interval = std::chrono::duration<double>(now - last).count();
+                m_Intervals++;
+                double delta = interval - m_IntervalMean;
+                m_IntervalMean += delta / double(m_Intervals);
+                m_IntervalM2 += delta * (interval - m_IntervalMean);
+                m_IntervalMax = std::max(m_IntervalMax, interval);
+            }
+            last = now;
+            m_Simulator.Simulate(frame, m_Dt);
+            m_SimPoints += m_Simulator.GetSimFrame().size();
+        }
+    }
+    IdnReceiver m_Receiver;
+    GalvoSimulator m_Simulator;
+    float m_Dt;
+    std::atomic<bool> m_Stop { false };
+    std::thread m_Thread;
+    size_t m_SimPoints = 0;
+    size_t m_Intervals = 0;
+    double m_IntervalMean = 0.0;
+    double m_IntervalM2 = 0.0;
+    double m_IntervalMax = 0.0;
+};
+
+// Color cost per point, exact HSV conversion vs baked table, and the table error
+static void ColorBenchmark()
+{
+    const int count = 4096;
+    const int rounds = 1000;
+    std::vector<float> t(count);
+    PointKernel::StepT(0, count, count - 1, t.data());
+    std::vector<LaserPoint> out(count);
+    struct Case
+    {
+        const char* name;
+        LaserColor color;
+    };
+    const Case cases[] = {
+        { "solid white", LaserColor(0.0f, 0.0f, 1.0f) },
+        { "solid green", LaserColor(LaserColor::RGB8 { 0, 255, 0 }) },
+        { "red-green", LaserColor(LaserColor::RGB8 { 255, 0, 0 }, LaserColor::RGB8 { 0, 255, 0 }) },
+        { "hue wheel", LaserColor(0.0f, 359.0f, 1.0f, 1.0f, 1.0f, 1.0f) },
+        { "dim fade", LaserColor(200.0f, 20.0f, 0.2f, 1.0f, 1.0f, 0.1f) },
+    };
+    unsigned checksum = 0;
+    for (const Case& c : cases)
+    {
+        auto t0 = Clock::now();
+        for (int i = 0; i < rounds; i++)
+        {
+            PointKernel::Colorize(c.color, t.data(), count, 1, out.data());
+            checksum += out[i % count].r;
+        }
+        auto t1 = Clock::now();
+        LaserColorTable table(c.color);
+        for (int i = 0; i < rounds; i++)
+        {
+            PointKernel::Colorize(table, t.data(), count, 1, out.data());
+            checksum += out[i % count].g;
+        }
+        auto t2 = Clock::now();
+        double points = double(count) * rounds;
+        LaserColorTable::ErrorReport error = table.MeasureError();
+        std::printf("%-12s exact %6.2f ns/pt, table %6.2f ns/pt, max error %d, mean error %.3f\n", c.name,
+            std::chrono::duration<double, std::nano>(t1 - t0).count() / points,
+            std::chrono::duration<double, std::nano>(t2 - t1).count() / points,
+            error.maxError, error.meanError);
+    }
+    std::printf("checksum %u\n", checksum);
+}
+
+// The bullet update as the AoS pools did it: one Bullet record per entity
+static void UpdateBulletsAoS(std::vector<Bullet>& bullets, int& activeCount, float dt)
+{
+    for (int i = 0; i < activeCount; )
+    {
+        Bullet& b = bullets[i];
+        b.m_Pos += b.m_Vel * dt;
+        b.m_Angle += b.m_AngVel * dt;
+        b.m_Lifetime -= dt;
+        if (b.m_Lifetime <= 0)
+            b = bullets[--activeCount];
+        else
+            ++i;
+    }
+}
+
+// Update cost per entity, AoS records vs EntityPool arrays, same spawn data
+static void PoolBenchmark()
+{
+    const float dt = 1.0f / 60.0f;
+    for (int count : { 256, 4096, 65536 })
+    {
+        std::vector<Bullet> aos(count);
+        EntityPool<BulletData> soa(count);
+        int aosActive = count;
+        for (int i = 0; i < count; i++)
+        {
+            Bullet& b = aos[i];
+            float a = PI2 * float(i) / float(count);
+            b.m_Vel = Point2D(std::cos(a), std::sin(a));
+            b.m_AngVel = 0.5f;
+            // A slice expires during the run so both paths exercise swap-remove
+            b.m_Lifetime = (i % 16 == 0) ? 1.0f : 1.0e6f;
+            soa.Spawn(b.m_Pos, b.m_Vel, b.m_Angle, b.m_AngVel, b.m_Lifetime, BulletData { b.m_ObjectMatrix, b.m_color });
+        }
+        const int rounds = std::max(120, 32 * 1024 * 1024 / count);
+        auto t0 = Clock::now();
+        for (int r = 0; r < rounds; r++)
+            UpdateBulletsAoS(aos, aosActive, dt);
+        auto t1 = Clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            soa.Integrate(dt);
+            soa.Age(dt);
+            soa.RemoveIf([&soa] (int i) { return soa.lifetime[i] <= 0; });
+        }
+        auto t2 = Clock::now();
+        float maxDiff = (aosActive == soa.activeCount) ? 0.0f : -1.0f;
+        for (int i = 0; maxDiff >= 0.0f && i < aosActive; i++)
+            maxDiff = std::max({ maxDiff, std::abs(aos[i].m_Pos.x - soa.posX[i]), std::abs(aos[i].m_Pos.y - soa.posY[i]) });
+        double updates = double(count) * rounds;
+        std::printf("%6d entities  AoS %6.3f ns/entity, SoA %6.3f ns/entity, %d alive, max difference %g\n", count,
+            std::chrono::duration<double, std::nano>(t1 - t0).count() / updates,
+            std::chrono::duration<double, std::nano>(t2 - t1).count() / updates,
+            soa.activeCount, maxDiff);
+    }
+}
+
+// Bullet/asteroid hit finding per frame, grid vs all pairs, on random fields of four bullets per asteroid
+static void CollisionBenchmark()
+{
+    const float bulletRadius = 0.002f;
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> field(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> size(0.002f, 0.01f);
+    for (int total : { 1000, 10000, 20000, 80000 })
+    {
+        int asteroidCount = total / 5;
+        int bulletCount = total - asteroidCount;
+        std::vector<float> ax(asteroidCount), ay(asteroidCount), ar(asteroidCount);
+        std::vector<float> bx(bulletCount), by(bulletCount);
+        for (int i = 0; i < asteroidCount; i++)
+        {
+            ax[i] = field(random);
+            ay[i] = field(random);
+            ar[i] = size(random);
+        }
+        for (int i = 0; i < bulletCount; i++)
+        {
+            bx[i] = field(random);
+            by[i] = field(random);
+        }
+        // About one cell per few asteroids keeps the candidate lists short at every size
+        SpatialHash grid(std::clamp(int(std::sqrt(float(asteroidCount))), 8, 256));
+        std::vector<SpatialHash::Hit> hits;
+        const int rounds = std::max(10, 2000000 / total);
+        auto t0 = Clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            hits.clear();
+            grid.Build(ax.data(), ay.data(), ar.data(), asteroidCount, bulletRadius);
+            grid.FindHits(bx.data(), by.data(), bulletCount, bulletRadius, [] (int) { return true; }, hits);
+        }
+        auto t1 = Clock::now();
+        double gridMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / rounds;
+
+        // All pairs, fewer rounds at the large sizes; also cross-checks the hit count
+        const int bruteRounds = std::max(1, rounds / 50);
+        size_t bruteHits = 0;
+        auto t2 = Clock::now();
+        for (int r = 0; r < bruteRounds; r++)
+        {
+            bruteHits = 0;
+            for (int i = 0; i < bulletCount; i++)
+            {
+                for (int a = 0; a < asteroidCount; a++)
+                {
+                    float dx = bx[i] - ax[a];
+                    float dy = by[i] - ay[a];
+                    float rr = ar[a] + bulletRadius;
+                    if (dx * dx + dy * dy <= rr * rr)
+                    {
+                        bruteHits++;
+                        break;
+                    }
+                }
+            }
+        }
+        auto t3 = Clock::now();
+        double bruteMs = std::chrono::duration<double, std::milli>(t3 - t2).count() / bruteRounds;
+        const SpatialHash::Stats& stats = grid.GetStats();
+        std::printf("%6d entities  grid %8.3f ms/frame (%d cells/side, %d tests), all pairs %9.3f ms/frame, hits %zu/%zu\n",
+            total, gridMs, grid.GetCellsPerSide(), stats.candidates, bruteMs, hits.size(), bruteHits);
+    }
+}
+
+// Heads on different scene frames and integrators, simulated serially and with
+// SimulateMany for several frames so state carries over; every SimFrame must match
+// bit for bit. Returns the number of mismatching head frames.
+static int CheckParallel(const Options& options)
+{
+    const float maxAngle = 35.0f;
+    const int heads = 8;
+    const int frames = 30;
+    const GalvoSimulator::Integrator integrators[] = {
+        GalvoSimulator::Integrator::EULER, GalvoSimulator::Integrator::EXACT, GalvoSimulator::Integrator::FIXED };
+    LaserFrameGenerator frameGenerator(0.9f, maxAngle);
+    ShapeGenerator shapeGenerator(frameGenerator);
+    Linkage linkage(frameGenerator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+    std::vector<GalvoSimulator> serial(heads, GalvoSimulator(maxAngle));
+    for (int head = 0; head < heads; head++)
+        serial[head].SetIntegrator(integrators[head % 3]);
+    std::vector<GalvoSimulator> parallel = serial;
+    // At least four threads, so the heads really are spread even on a single core
+    ThreadPool pool(std::max(4u, options.threads > 0 ? unsigned(options.threads) : std::thread::hardware_concurrency()));
+    std::vector<LaserFrame> laserFrames(heads);
+    std::vector<const LaserFrame*> framePointers(heads);
+    float dt = options.fps / options.simstepsPerSecond;
+    int mismatches = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (int head = 0; head < heads; head++)
+        {
+            frameGenerator.NewFrame();
+            DrawScene(shapeGenerator, linkage, frame + 17 * head, options.bullets, options.fps);
+            frameGenerator.EndFrame();
+            const LaserFrame& laserFrame = frameGenerator.GetLaserFrame();
+            laserFrames[head].assign(laserFrame.begin(), laserFrame.end());
+            framePointers[head] = &laserFrames[head];
+        }
+        for (int head = 0; head < heads; head++)
+            serial[head].Simulate(laserFrames[head], dt);
+        GalvoSimulator::SimulateMany(parallel, framePointers, dt, pool);
+        for (int head = 0; head < heads; head++)
+        {
+            const SimFrame& a = serial[head].GetSimFrame();
+            const SimFrame& b = parallel[head].GetSimFrame();
+            if (a.size() != b.size() || std::memcmp(a.data(), b.data(), a.size() * sizeof(SimPoint)) != 0)
+            {
+                std::printf("frame %d head %d: parallel SimFrame differs (%zu vs %zu steps)\n", frame, head, b.size(), a.size());
+                mismatches++;
+            }
+        }
+    }
+    std::printf("check parallel  %d heads x %d frames on %u threads, %d mismatches\n", heads, frames, pool.GetThreadCount(), mismatches);
+    return mismatches;
+}
+
+// The headless scene generated and simulated on one head, with the frame options
+// given, heap-backed and then arena-backed frame buffers. After a warm-up that
+// reaches the high water marks, no frame may touch the heap. Returns the number
+// of allocations seen.
+static uint64_t CheckAllocations(const Options& options)
+{
+    const float maxAngle = 35.0f;
+    // One turn of the linkage, the scene's longest changing cycle, so every buffer has seen its high water
+    const int warmup = int(std::ceil(PI * options.fps));
+    const int frames = 600;
+    float dt = options.fps / options.simstepsPerSecond;
+    uint64_t total = 0;
+    for (bool arena : { false, true })
+    {
+        // Arenas first: they must outlive the buffers placed in them
+        FrameArena laserArena(4 << 20);
+        FrameArena simArena(8 << 20);
+        LaserFrameGenerator frameGenerator(0.9f, maxAngle);
+        if (options.lut)
+            frameGenerator.SetCorrectionMode(DistortionCorrector::Mode::LUT);
+        if (options.pps > 0.0f)
+            frameGenerator.SetPointBudget(options.pps, options.fps);
+        ShapeGenerator shapeGenerator(frameGenerator);
+        shapeGenerator.SetShapeTemplates(options.templates);
+        PathOptimizer pathOptimizer(frameGenerator);
+        if (options.optimize)
+            shapeGenerator.SetPathOptimizer(&pathOptimizer);
+        Linkage linkage(frameGenerator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+        GalvoSimulator simulator(maxAngle);
+        if (options.exact)
+            simulator.SetIntegrator(GalvoSimulator::Integrator::EXACT);
+        if (options.fixed)
+            simulator.SetIntegrator(GalvoSimulator::Integrator::FIXED);
+        if (arena)
+        {
+            frameGenerator.SetFrameMemory(&laserArena);
+            simulator.SetFrameMemory(&simArena);
+        }
+        uint64_t before = 0;
+        int worstFrame = -1;
+        uint64_t worst = 0;
+        for (int frame = 0; frame < warmup + frames; frame++)
+        {
+            if (frame == warmup)
+                before = AllocationCounter::Get();
+            uint64_t frameStart = AllocationCounter::Get();
+            frameGenerator.NewFrame();
+            DrawScene(shapeGenerator, linkage, frame, options.bullets, options.fps);
+            frameGenerator.EndFrame();
+            simulator.Simulate(frameGenerator.GetLaserFrame(), dt);
+            uint64_t made = AllocationCounter::Get() - frameStart;
+            if (frame >= warmup && made > worst)
+            {
+                worst = made;
+                worstFrame = frame;
+            }
+        }
+        uint64_t allocations = AllocationCounter::Get() - before;
+        total += allocations;
+        std::printf("check allocs    %-5s %llu allocations in %d frames", arena ? "arena" : "heap",
+            (unsigned long long)allocations, frames);
+        if (allocations)
+            std::printf(", worst frame %d with %llu", worstFrame, (unsigned long long)worst);
+        if (arena)
+            std::printf(", %zu arena heap fallbacks", laserArena.GetHeapAllocations() + simArena.GetHeapAllocations());
+        std::printf("\n");
+    }
+    return total;
+}
+
+// Grows the bullet ring from a quarter of --bullets to all of it a few bullets
+// per frame, then holds it. Every frame after the first must fit in what
+// FrameBufferPolicy reserved up front, and once the size holds the policies
+// must stop reallocating. Returns the number of problems found.
+static int CheckFrameGrowth(const Options& options)
+{
+    const float maxAngle = 35.0f;
+    const int first = std::max(options.bullets / 4, 1);
+    const int step = std::max(options.bullets / 64, 1);
+    const int growFrames = (options.bullets - first + step - 1) / step;
+    const int holdFrames = 120;
+    float dt = options.fps / options.simstepsPerSecond;
+    LaserFrameGenerator frameGenerator(0.9f, maxAngle);
+    ShapeGenerator shapeGenerator(frameGenerator);
+    Linkage linkage(frameGenerator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+    GalvoSimulator simulator(maxAngle);
+    int midFrameGrowths = 0;
+    size_t laserHeld = 0;
+    size_t simHeld = 0;
+    for (int frame = 0; frame < growFrames + holdFrames; frame++)
+    {
+        // Frame growFrames is the first at full size; the Prepare of the one after reacts to it
+        if (frame == growFrames + 2)
+        {
+            laserHeld = frameGenerator.GetFramePolicy().GetStats().reallocations;
+            simHeld = simulator.GetFramePolicy().GetStats().reallocations;
+        }
+        int bullets = std::min(first + frame * step, options.bullets);
+        frameGenerator.NewFrame();
+        DrawScene(shapeGenerator, linkage, 0, bullets, options.fps);
+        frameGenerator.EndFrame();
+        simulator.Simulate(frameGenerator.GetLaserFrame(), dt);
+        // Frame 0 starts from an empty buffer. After that the policy's capacity, what
+        // Prepare left at the start of the frame, must still hold the whole frame.
+        if (frame == 0)
+            continue;
+        if (frameGenerator.GetLaserFrame().capacity() != frameGenerator.GetFramePolicy().GetStats().capacity)
+        {
+            std::printf("frame %d: laser frame grew mid-frame to %zu points\n", frame, frameGenerator.GetLaserFrame().size());
+            midFrameGrowths++;
+        }
+        if (simulator.GetSimFrame().capacity() != simulator.GetFramePolicy().GetStats().capacity)
+        {
+            std::printf("frame %d: sim frame grew mid-frame to %zu points\n", frame, simulator.GetSimFrame().size());
+            midFrameGrowths++;
+        }
+    }
+    size_t laserReallocations = frameGenerator.GetFramePolicy().GetStats().reallocations;
+    size_t simReallocations = simulator.GetFramePolicy().GetStats().reallocations;
+    int problems = midFrameGrowths;
+    if (laserReallocations != laserHeld || simReallocations != simHeld)
+    {
+        std::printf("reallocations kept rising once the frame size held: laser %zu -> %zu, sim %zu -> %zu\n",
+            laserHeld, laserReallocations, simHeld, simReallocations);
+        problems++;
+    }
+    std::printf("check growth    %d -> %d bullets over %d frames, %zu laser and %zu sim reallocations, %d problems\n",
+        first, options.bullets, growFrames, laserHeld, simHeld, problems);
+    return problems;
+}
+
+// Writes scene frames through IldaWriter, reads the file back with IldaReader
+// and compares point for point against what the format keeps: blanking as a
+// single bit, at most 65535 points and an empty frame as one blanked point.
+// Write errors reported by Close fail the check too. Returns the number of
+// problems found.
+static int CheckIlda(const Options& options)
+{
+    const float maxAngle = 35.0f;
+    const int frames = 120;
+    LaserFrameGenerator frameGenerator(0.9f, maxAngle);
+    ShapeGenerator shapeGenerator(frameGenerator);
+    Linkage linkage(frameGenerator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+    std::vector<LaserFrame> expected(frames);
+    IldaWriter::Stats stats;
+    try
+    {
+        IldaWriter writer(options.checkIldaPath);
+        LaserFrame empty;
+        LaserPoint last {};
+        for (int frame = 0; frame < frames; frame++)
+        {
+            LaserFrame& copy = expected[frame];
+            // Every so often an empty frame, which must still take up its place in the file
+            if (frame % 40 == 39)
+            {
+                writer.WriteFrame(empty);
+                copy.assign(1, LaserPoint { last.x, last.y, 0, 0, 0, 0 });
+                continue;
+            }
+            frameGenerator.NewFrame();
+            DrawScene(shapeGenerator, linkage, frame, options.bullets, options.fps);
+            frameGenerator.EndFrame();
+            const LaserFrame& laserFrame = frameGenerator.GetLaserFrame();
+            writer.WriteFrame(laserFrame);
+            copy.assign(laserFrame.begin(), laserFrame.begin() + std::min<size_t>(laserFrame.size(), 65535));
+            for (LaserPoint& point : copy)
+                point.flags = point.flags ? 1 : 0;
+            last = copy.back();
+        }
+        writer.Close();
+        stats = writer.GetStats();
+    }
+    catch (const std::exception& e)
+    {
+        std::printf("check ilda      FAILED: %s\n", e.what());
+        return 1;
+    }
+
+    int problems = 0;
+    IldaReader reader(options.checkIldaPath);
+    LaserFrame frame;
+    int read = 0;
+    while (reader.NextFrame(frame))
+    {
+        if (read < frames && (frame.size() != expected[read].size() ||
+            std::memcmp(frame.data(), expected[read].data(), frame.size() * sizeof(LaserPoint)) != 0))
+        {
+            std::printf("frame %d: read back differs (%zu vs %zu points)\n", read, frame.size(), expected[read].size());
+            problems++;
+        }
+        read++;
+    }
+    if (read != frames)
+    {
+        std::printf("read back %d frames, wrote %d\n", read, frames);
+        problems++;
+    }
+    std::printf("check ilda      %d frames, %zu bytes in %zu writes, %d problems\n", read, stats.bytesWritten, stats.writeCalls, problems);
+    return problems;
+}
+
+// Profiles scene frames on one head, writes the CSV and reads it back. Every
+// frame must have a row, and every row a value in each column: an empty
+// stage cell means the event rings wrapped before the frame ring did.
+// Returns the number of problems found.
+static int CheckProfile(const Options& options)
+{
+    const float maxAngle = 35.0f;
+    const int frames = 300;
+    float dt = options.fps / options.simstepsPerSecond;
+    LaserFrameGenerator frameGenerator(0.9f, maxAngle);
+    ShapeGenerator shapeGenerator(frameGenerator);
+    PathOptimizer pathOptimizer(frameGenerator);
+    shapeGenerator.SetPathOptimizer(&pathOptimizer);
+    Linkage linkage(frameGenerator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+    GalvoSimulator simulator(maxAngle);
+    Profiler& profiler = Profiler::Get();
+    profiler.Clear();
+    profiler.Enable(true);
+    Profiler::FrameCounters counters;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        profiler.BeginFrame();
+        frameGenerator.NewFrame();
+        DrawScene(shapeGenerator, linkage, frame, options.bullets, options.fps);
+        frameGenerator.EndFrame();
+        simulator.Simulate(frameGenerator.GetLaserFrame(), dt);
+        counters.CountLit(frameGenerator.GetLaserFrame());
+        counters.CountDraws(frameGenerator.GetDrawCalls());
+        counters.simSteps = simulator.GetSimFrame().size();
+        profiler.EndFrame(counters);
+    }
+    profiler.Enable(false);
+    if (!profiler.WriteCsv(options.checkProfilePath))
+    {
+        std::printf("check profile   FAILED to write %s\n", options.checkProfilePath.c_str());
+        return 1;
+    }
+
+    FILE* file = std::fopen(options.checkProfilePath.c_str(), "r");
+    if (!file)
+    {
+        std::printf("check profile   FAILED to read %s\n", options.checkProfilePath.c_str());
+        return 1;
+    }
+    // Splits a line into its cells, empty ones included
+    auto split = [] (const std::string& line)
+    {
+        std::vector<std::string> cells;
+        size_t begin = 0;
+        for (size_t comma; (comma = line.find(',', begin)) != std::string::npos; begin = comma + 1)
+            cells.push_back(line.substr(begin, comma - begin));
+        cells.push_back(line.substr(begin));
+        return cells;
+    };
+    char buffer[4096];
+    std::vector<std::string> header;
+    int problems = 0;
+    int rows = 0;
+    while (std::fgets(buffer, sizeof(buffer), file))
+    {
+        std::string line(buffer);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            line.pop_back();
+        if (header.empty())
+        {
+            header = split(line);
+            continue;
+        }
+        std::vector<std::string> cells = split(line);
+        if (cells.size() != header.size())
+        {
+            std::printf("row %d: %zu cells, header has %zu\n", rows, cells.size(), header.size());
+            problems++;
+        }
+        else
+        {
+            for (size_t i = 0; i < cells.size(); i++)
+            {
+                if (!cells[i].empty())
+                    continue;
+                std::printf("row %d: no %s\n", rows, header[i].c_str());
+                problems++;
+                break;
+            }
+        }
+        rows++;
+    }
+    std::fclose(file);
+    // frame, start and frame time come first; anything before the counters is a stage
+    size_t stages = 0;
+    for (size_t i = 3; i < header.size() && header[i] != "laser_points"; i++)
+        stages++;
+    if (stages == 0)
+    {
+        std::printf("no stage columns\n");
+        problems++;
+    }
+    if (rows != frames)
+    {
+        std::printf("read back %d rows, profiled %d frames\n", rows, frames);
+        problems++;
+    }
+    std::printf("check profile   %d rows, %zu stages, %d problems\n", rows, stages, problems);
+    return problems;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    // The loopback receiver simulates in place of the frame loop, leaving nothing to render
+    if (!ParseOptions(argc, argv, options) || (options.pipelineDepth > 0 && options.heads > 1) ||
+        (options.idnLoopback && !options.renderPrefix.empty()))
+    {
+        PrintUsage();
+        return 1;
+    }
+    if (options.colorBench)
+    {
+        ColorBenchmark();
+        return 0;
+    }
+    if (options.poolBench)
+    {
+        PoolBenchmark();
+        return 0;
+    }
+    if (options.collisionBench)
+    {
+        CollisionBenchmark();
+        return 0;
+    }
+    if (options.checkParallel)
+        return CheckParallel(options) == 0 ? 0 : 1;
+    if (options.checkAllocations)
+        return CheckAllocations(options) == 0 ? 0 : 1;
+    if (options.checkFrameGrowth)
+        return CheckFrameGrowth(options) == 0 ? 0 : 1;
+    if (!options.checkIldaPath.empty())
+        return CheckIlda(options) == 0 ? 0 : 1;
+    if (!options.checkProfilePath.empty())
+        return CheckProfile(options) == 0 ? 0 : 1;
+
+    const float maxAngle = 35.0f;
+    LaserFrameGenerator frameGenerator(0.9f, maxAngle);
+    if (options.lut)
+        frameGenerator.SetCorrectionMode(DistortionCorrector::Mode::LUT);
+    ShapeGenerator shapeGenerator(frameGenerator);
+    shapeGenerator.SetShapeTemplates(options.templates);
+    PathOptimizer pathOptimizer(frameGenerator);
+    if (options.optimize)
+        shapeGenerator.SetPathOptimizer(&pathOptimizer);
+    if (options.pps > 0.0f)
+        frameGenerator.SetPointBudget(options.pps, options.fps);
+    Linkage linkage(frameGenerator, Point2D(2.0f, 0.5f), 1.0f, 1.5f, 2.5f, 4.0f);
+
+    std::vector<GalvoSimulator> simulators(options.heads, GalvoSimulator(maxAngle));
+    for (GalvoSimulator& simulator : simulators)
+    {
+        if (options.exact)
+            simulator.SetIntegrator(GalvoSimulator::Integrator::EXACT);
+        if (options.fixed)
+            simulator.SetIntegrator(GalvoSimulator::Integrator::FIXED);
+    }
+    ThreadPool pool(options.threads > 0 ? unsigned(options.threads) : std::thread::hardware_concurrency());
+    std::vector<const LaserFrame*> frames(options.heads);
+    std::unique_ptr<IldaWriter> ilda;
+    if (!options.ildaPath.empty())
+        ilda = std::make_unique<IldaWriter>(options.ildaPath);
+
+    float simsteps = options.simstepsPerSecond / options.fps;
+    float dt = 1.0f / simsteps;
+    // Rasterizes one sim frame and writes it out; on the pipeline thread when pipelined
+    std::unique_ptr<SoftwareRenderer> renderer;
+    double renderSeconds = 0.0;
+    int renderedFrames = 0;
+    if (!options.renderPrefix.empty())
+    {
+        renderer = std::make_unique<SoftwareRenderer>(options.renderWidth, options.renderHeight, &pool);
+        renderer->SetPersistence(options.persistenceMs / 1000.0f);
+    }
+    auto render = [&] (const SimFrame& simFrame)
+    {
+        auto r0 = Clock::now();
+        renderer->DrawFrame(simFrame, 1.0f / options.fps);
+        renderSeconds += std::chrono::duration<double>(Clock::now() - r0).count();
+        char name[32];
+        std::snprintf(name, sizeof(name), "%05d.ppm", renderedFrames++);
+        renderer->WritePpm(options.renderPrefix + name);
+    };
+    // IDN: the loopback receiver simulates in place of the frame loop
+    std::unique_ptr<IdnLoopback> idnLoopback;
+    std::unique_ptr<IdnSender> idn;
+    double sendSeconds = 0.0;
+    if (options.idnLoopback)
+    {
+        idnLoopback = std::make_unique<IdnLoopback>(maxAngle, dt);
+        options.idnHost = "127.0.0.1";
+        options.idnPort = idnLoopback->GetPort();
+    }
+    if (!options.idnHost.empty())
+    {
+        float pps = options.idnPps > 0.0f ? options.idnPps : (options.pps > 0.0f ? options.pps : 30000.0f);
+        idn = std::make_unique<IdnSender>(options.idnHost, options.idnPort, pps);
+        idn->SetPacing(options.idnPace);
+    }
+    // DAC playback: frames are queued here and played out on the playback thread
+    std::unique_ptr<PointFileWriter> dacFile;
+    std::unique_ptr<DacPlayback> dac;
+    if (!options.dacSink.empty())
+    {
+        DacPlayback::Sink sink;
+        if (options.dacSink != "null")
+        {
+            dacFile = std::make_unique<PointFileWriter>(options.dacSink);
+            sink = [&dacFile] (const LaserPoint* points, size_t count) { dacFile->Write(points, count); };
+        }
+        float pps = options.dacPps > 0.0f ? options.dacPps : (options.pps > 0.0f ? options.pps : 30000.0f);
+        dac = std::make_unique<DacPlayback>(sink, pps);
+        if (options.dacPark)
+            dac->SetUnderrun(DacPlayback::Underrun::BLANK_PARK);
+        dac->Start();
+    }
+    // Pipelined: the consumer thread counts and renders, everything it reads is in the slot.
+    // The pool is otherwise idle with a single head, so the renderer may use it from there.
+    size_t pipelineSimPoints = 0;
+    std::unique_ptr<FramePipeline> pipeline;
+    if (options.pipelineDepth > 0)
+    {
+        pipeline = std::make_unique<FramePipeline>(simulators[0], dt, options.pipelineDepth,
+            [&] (const LaserFrame&, const SimFrame& simFrame)
+            {
+                pipelineSimPoints += simFrame.size();
+                if (renderer)
+                    render(simFrame);
+            });
+    }
+
+    size_t laserPoints = 0;
+    double blankBefore = 0.0;
+    double blankAfter = 0.0;
+    size_t blankPointsSaved = 0;
+    size_t requestedPoints = 0;
+    int overBudgetFrames = 0;
+    int worstSlack = 0;
+    double spacingSum = 0.0;
+    size_t simPoints = 0;
+    double generateSeconds = 0.0;
+    double simulateSeconds = 0.0;
+    Profiler& profiler = Profiler::Get();
+    profiler.Enable(!options.profilePath.empty());
+    Profiler::FrameCounters counters;
+    // Scene time follows the frame number, so the clock here only paces and measures
+    FixedStepClock frameClock(1.0 / options.fps);
+    frameClock.SetFrameCap(options.cap);
+    auto start = Clock::now();
+    for (int frame = 0; frame < options.frames; frame++)
+    {
+        if (options.cap > 0.0f)
+        {
+            frameClock.WaitForNextFrame();
+            frameClock.BeginFrame();
+        }
+        auto t0 = Clock::now();
+        profiler.BeginFrame();
+        if (pipeline)
+            pipeline->BeginFrame();
+        frameGenerator.NewFrame();
+        DrawScene(shapeGenerator, linkage, frame, options.bullets, options.fps);
+        frameGenerator.EndFrame();
+        const LaserFrame& laserFrame = frameGenerator.GetLaserFrame();
+        if (ilda)
+            ilda->WriteFrame(laserFrame);
+        if (options.optimize)
+        {
+            const PathOptimizer::Stats& stats = pathOptimizer.GetStats();
+            blankBefore += stats.blankDistanceBefore;
+            blankAfter += stats.blankDistanceAfter;
+            blankPointsSaved += size_t(std::max(stats.PointsSaved(), 0));
+        }
+        if (options.pps > 0.0f)
+        {
+            const LaserFrameGenerator::BudgetStats& stats = frameGenerator.GetBudgetStats();
+            requestedPoints += size_t(stats.requestedPoints);
+            spacingSum += stats.spacing;
+            if (stats.OverBudget())
+                overBudgetFrames++;
+            worstSlack = (frame == 0) ? stats.Slack() : std::min(worstSlack, stats.Slack());
+        }
+        auto t1 = Clock::now();
+        laserPoints += laserFrame.size();
+        generateSeconds += std::chrono::duration<double>(t1 - t0).count();
+        if (profiler.IsEnabled())
+        {
+            counters.CountLit(laserFrame);
+            counters.CountDraws(frameGenerator.GetDrawCalls());
+        }
+        if (dac)
+            dac->SubmitFrame(laserFrame);
+        if (idn)
+        {
+            auto s0 = Clock::now();
+            idn->SendFrame(laserFrame);
+            sendSeconds += std::chrono::duration<double>(Clock::now() - s0).count();
+            if (idnLoopback)
+            {
+                profiler.EndFrame(counters);
+                continue;
+            }
+        }
+        if (pipeline)
+        {
+            // Sim steps land on the pipeline thread after the frame is closed, so they are not counted here
+            pipeline->Submit(laserFrame);
+            profiler.EndFrame(counters);
+            continue;
+        }
+        for (const LaserFrame*& f : frames)
+            f = &laserFrame;
+        if (simulators.size() == 1)
+            simulators[0].Simulate(laserFrame, dt);
+        else
+            GalvoSimulator::SimulateMany(simulators, frames, dt, pool);
+        auto t2 = Clock::now();
+
+        counters.simSteps = 0;
+        for (GalvoSimulator& simulator : simulators)
+            counters.simSteps += simulator.GetSimFrame().size();
+        simPoints += counters.simSteps;
+        simulateSeconds += std::chrono::duration<double>(t2 - t1).count();
+        if (renderer)
+            render(simulators[0].GetSimFrame());
+        profiler.EndFrame(counters);
+    }
+    if (pipeline)
+    {
+        pipeline->Flush();
+        FramePipeline::Stats stats = pipeline->GetStats();
+        simPoints = pipelineSimPoints;
+        simulateSeconds = stats.simulate.totalMs / 1000.0;
+        auto stage = [] (const char* name, const StageStats& s)
+        {
+            std::printf("  %-9s avg %7.3f ms, max %7.3f ms\n", name, s.AverageMs(), s.maxMs);
+        };
+        std::printf("pipeline        depth %d\n", pipeline->GetDepth());
+        stage("generate", stats.generate);
+        stage("stall", stats.stall);
+        stage("simulate", stats.simulate);
+        stage("consume", stats.consume);
+        stage("latency", stats.latency);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (profiler.IsEnabled())
+    {
+        const std::string& path = options.profilePath;
+        bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        bool written = json ? profiler.WriteChromeTrace(path) : profiler.WriteCsv(path);
+        std::printf("profile         %s %s\n", written ? "written to" : "FAILED to write", path.c_str());
+    }
+    if (options.cap > 0.0f)
+    {
+        FixedStepClock::Stats stats = frameClock.GetStats();
+        std::printf("pacing          %.3f ms mean, %.3f ms jitter, %.3f ms max, %llu missed deadlines\n",
+            stats.meanFrameMs, stats.jitterMs, stats.maxFrameMs, (unsigned long long)stats.missedDeadlines);
+    }
+    if (options.optimize)
+    {
+        std::printf("blank distance  %.2f -> %.2f per frame, %.0f blank points saved per frame\n",
+            blankBefore / options.frames, blankAfter / options.frames, double(blankPointsSaved) / options.frames);
+    }
+    if (options.pps > 0.0f)
+    {
+        std::printf("point budget    %d pts/frame, %.0f requested, spacing %.4f, %d frames over, worst slack %d\n",
+            frameGenerator.GetBudgetStats().budget, double(requestedPoints) / options.frames, spacingSum / options.frames,
+            overBudgetFrames, worstSlack);
+    }
+    if (ilda)
+    {
+        ilda->Close();
+        IldaWriter::Stats stats = ilda->GetStats();
+        std::printf("ilda            %zu frames, %zu bytes, %zu writes, %zu truncated, %zu failed, max queue %zu\n",
+            stats.framesWritten, stats.bytesWritten, stats.writeCalls, stats.truncatedFrames, stats.failedFrames, stats.maxQueued);
+    }
+
+    if (dac)
+    {
+        dac->Stop();
+        DacPlayback::Stats stats = dac->GetStats();
+        std::printf("dac             %llu points played, %llu of %llu frames, %llu overruns, %llu underruns (%llu repeats, %llu parked points)\n",
+            (unsigned long long)stats.pointsPlayed, (unsigned long long)stats.framesPlayed, (unsigned long long)stats.framesSubmitted,
+            (unsigned long long)stats.overruns, (unsigned long long)stats.underruns, (unsigned long long)stats.repeatedFrames,
+            (unsigned long long)stats.parkedPoints);
+        std::printf("dac timing      %.3f ms mean, %.3f ms max wake-up lateness, %llu points skipped, fill %zu now, %zu max\n",
+            stats.meanWakeLateMs, stats.maxWakeLateMs, (unsigned long long)stats.skippedPoints, stats.fillPoints, stats.maxFillPoints);
+        if (dacFile)
+            dacFile->Close();
+    }
+    if (idn)
+    {
+        idn->Close();
+        const IdnSender::Stats& stats = idn->GetStats();
+        std::printf("idn send        %zu frames, %zu packets, %zu bytes in %zu calls, %zu errors, %zu late, %.3f ms/frame\n",
+            stats.framesSent, stats.packetsSent, stats.bytesSent, stats.sendCalls, stats.sendErrors, stats.lateFrames,
+            1000.0 * sendSeconds / std::max<size_t>(stats.framesSent, 1));
+    }
+    if (idnLoopback)
+    {
+        idnLoopback->Stop();
+        idnLoopback->Print();
+    }
+    if (renderer)
+    {
+        std::printf("render          %d frames at %dx%d, %.3f ms/frame rasterize, %zu lit segments in the last\n",
+            renderedFrames, renderer->GetWidth(), renderer->GetHeight(), 1000.0 * renderSeconds / std::max(renderedFrames, 1),
+            renderer->GetStats().litSegments);
+    }
+    std::printf("frames          %d (%d heads, %u threads)\n", options.frames, options.heads, pool.GetThreadCount());
+    std::printf("total time      %.3f s (generate %.3f s, simulate %.3f s)\n", seconds, generateSeconds, simulateSeconds);
+    std::printf("frames/sec      %.1f\n", options.frames / seconds);
+    std::printf("laser pts/frame %.0f\n", double(laserPoints) / options.frames);
+    std::printf("laser pts/sec   %.0f (generate only %.0f)\n", laserPoints / seconds, laserPoints / generateSeconds);
+    // Nothing is simulated here with --idn-loopback; the receiver reports its own
+    if (simulateSeconds > 0.0)
+        std::printf("sim pts/sec     %.0f (simulate only %.0f)\n", simPoints / seconds, simPoints / simulateSeconds);
+    return 0;
+}
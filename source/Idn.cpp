@@ -0,0 +1,562 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Idn.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#undef max
+#undef min
+using NativeSocket = SOCKET;
+#else
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+using NativeSocket = int;
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// Largest datagram that fits a 1500 byte Ethernet MTU after IPv4 and UDP headers
+static constexpr size_t MAX_DATAGRAM = 1472;
+// Receive slots are larger so jumbo datagrams from other senders are not cut
+static constexpr size_t RECEIVE_SLOT = 9000;
+
+// IDN-Hello
+static constexpr uint8_t CMD_RT_CNLMSG = 0x40;
+static constexpr uint8_t CMD_RT_CNLMSG_ACKREQ = 0x41;
+static constexpr uint8_t CMD_RT_CNLMSG_CLOSE = 0x44;
+// IDN-Stream channel message content ID
+static constexpr uint16_t CONTENT_CHANNEL_MSG = 0x8000;
+static constexpr uint16_t CONTENT_CONFIG_OR_LAST = 0x4000; // config present (first) / last fragment (sequel)
+static constexpr uint8_t CHUNK_FRAME = 0x02;
+static constexpr uint8_t CHUNK_FRAME_FIRST = 0x03;
+static constexpr uint8_t CHUNK_FRAME_SEQUEL = 0xC0;
+static constexpr uint8_t CONFIG_ROUTING = 0x01;
+static constexpr uint8_t CONFIG_CLOSE = 0x02;
+static constexpr uint8_t SERVICE_ID = 1;
+static constexpr uint8_t SERVICE_MODE_DISCRETE = 0x02;
+// Sample layout: X and Y at 16 bits, then red 638 nm, green 532 nm, blue 460 nm at 8 bits, void pad
+static constexpr uint16_t SAMPLE_TAGS[] = { 0x4200, 0x4010, 0x4210, 0x4010, 0x527E, 0x5214, 0x51CC, 0x0000 };
+static constexpr size_t TAG_WORDS = sizeof(SAMPLE_TAGS) / 4;
+static constexpr size_t SAMPLE_SIZE = 7;
+
+static constexpr size_t HELLO_HEADER = 4;
+static constexpr size_t CHANNEL_HEADER = 8;
+static constexpr size_t CONFIG_HEADER = 4 + TAG_WORDS * 4;
+static constexpr size_t CHUNK_HEADER = 4;
+static constexpr size_t FIRST_HEADER = HELLO_HEADER + CHANNEL_HEADER + CONFIG_HEADER + CHUNK_HEADER;
+static constexpr size_t SEQUEL_HEADER = HELLO_HEADER + CHANNEL_HEADER;
+static constexpr size_t FIRST_SAMPLES = (MAX_DATAGRAM - FIRST_HEADER) / SAMPLE_SIZE;
+static constexpr size_t SEQUEL_SAMPLES = (MAX_DATAGRAM - SEQUEL_HEADER) / SAMPLE_SIZE;
+
+static void PutU16(uint8_t* p, uint16_t v)
+{
+    p[0] = uint8_t(v >> 8);
+    p[1] = uint8_t(v);
+}
+
+static void PutU32(uint8_t* p, uint32_t v)
+{
+    p[0] = uint8_t(v >> 24);
+    p[1] = uint8_t(v >> 16);
+    p[2] = uint8_t(v >> 8);
+    p[3] = uint8_t(v);
+}
+
+static uint16_t GetU16(const uint8_t* p)
+{
+    return uint16_t((p[0] << 8) | p[1]);
+}
+
+static uint32_t GetU24(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+}
+
+#ifdef _WIN32
+static void StartSockets()
+{
+    struct Startup
+    {
+        Startup()
+        {
+            WSADATA data;
+            WSAStartup(MAKEWORD(2, 2), &data);
+        }
+        ~Startup() { WSACleanup(); }
+    };
+    static Startup startup;
+}
+
+static void CloseSocket(intptr_t s)
+{
+    closesocket(NativeSocket(s));
+}
+#else
+static void StartSockets()
+{
+}
+
+static void CloseSocket(intptr_t s)
+{
+    close(NativeSocket(s));
+}
+#endif
+
+// Waits until the socket has a datagram or timeoutMs passes
+static bool WaitReadable(intptr_t s, int timeoutMs)
+{
+#ifdef _WIN32
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(NativeSocket(s), &set);
+    timeval timeout { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+    return select(0, &set, nullptr, nullptr, &timeout) > 0;
+#else
+    pollfd fd { NativeSocket(s), POLLIN, 0 };
+    return poll(&fd, 1, timeoutMs) > 0;
+#endif
+}
+
+#ifdef _WIN32
+struct IdnSender::Batch
+{
+};
+struct IdnReceiver::Batch
+{
+};
+#else
+struct IdnSender::Batch
+{
+    std::vector<mmsghdr> messages;
+    std::vector<iovec> vectors;
+};
+struct IdnReceiver::Batch
+{
+    std::vector<mmsghdr> messages;
+    std::vector<iovec> vectors;
+};
+#endif
+
+IdnSender::IdnSender(const std::string& host, uint16_t port, float pointsPerSecond, size_t maxFramePoints) :
+    m_PointsPerSecond(pointsPerSecond),
+    m_MaxFramePoints(std::max<size_t>(maxFramePoints, 1)),
+    m_Batch(std::make_unique<Batch>())
+{
+    StartSockets();
+    addrinfo hints {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* address = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &address) != 0 || !address)
+        throw std::runtime_error("Failed to resolve IDN host " + host);
+    intptr_t s = intptr_t(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    // Connected, so every datagram goes to the DAC without an address of its own
+    bool connected = s != -1 && connect(NativeSocket(s), address->ai_addr, int(address->ai_addrlen)) == 0;
+    freeaddrinfo(address);
+    if (!connected)
+    {
+        if (s != -1)
+            CloseSocket(s);
+        throw std::runtime_error("Failed to open IDN socket to " + host);
+    }
+    m_Socket = s;
+
+    m_MaxPackets = 1 + (m_MaxFramePoints + SEQUEL_SAMPLES - 1) / SEQUEL_SAMPLES;
+    m_Buffer.resize(m_MaxPackets * MAX_DATAGRAM);
+    m_Sizes.resize(m_MaxPackets);
+#ifndef _WIN32
+    m_Batch->messages.resize(m_MaxPackets);
+    m_Batch->vectors.resize(m_MaxPackets);
+    for (size_t i = 0; i < m_MaxPackets; i++)
+    {
+        m_Batch->vectors[i].iov_base = m_Buffer.data() + i * MAX_DATAGRAM;
+        m_Batch->messages[i] = {};
+        m_Batch->messages[i].msg_hdr.msg_iov = &m_Batch->vectors[i];
+        m_Batch->messages[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+    m_Start = Clock::now();
+    m_NextSend = m_Start;
+}
+
+IdnSender::~IdnSender()
+{
+    Close();
+    if (m_Socket != -1)
+        CloseSocket(m_Socket);
+}
+
+size_t IdnSender::Pack(const LaserFrame& frame, uint32_t durationUs)
+{
+    size_t points = std::min(frame.size(), m_MaxFramePoints);
+    uint32_t timestamp = uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(m_NextSend - m_Start).count());
+    size_t count = 0;
+    size_t next = 0;
+    do
+    {
+        bool first = count == 0;
+        uint8_t* packet = m_Buffer.data() + count * MAX_DATAGRAM;
+        size_t samples = std::min(first ? FIRST_SAMPLES : SEQUEL_SAMPLES, points - next);
+        bool last = next + samples == points;
+        size_t header = first ? FIRST_HEADER : SEQUEL_HEADER;
+        uint16_t content = CONTENT_CHANNEL_MSG;
+        if (first)
+            content |= CONTENT_CONFIG_OR_LAST | (last ? CHUNK_FRAME : CHUNK_FRAME_FIRST);
+        else
+            content |= (last ? CONTENT_CONFIG_OR_LAST : 0) | CHUNK_FRAME_SEQUEL;
+
+        packet[0] = CMD_RT_CNLMSG;
+        packet[1] = 0;
+        PutU16(packet + 2, m_Sequence++);
+        PutU16(packet + 4, uint16_t(header - HELLO_HEADER + samples * SAMPLE_SIZE));
+        PutU16(packet + 6, content);
+        PutU32(packet + 8, timestamp);
+        uint8_t* p = packet + HELLO_HEADER + CHANNEL_HEADER;
+        if (first)
+        {
+            p[0] = uint8_t(TAG_WORDS);
+            p[1] = CONFIG_ROUTING;
+            p[2] = SERVICE_ID;
+            p[3] = SERVICE_MODE_DISCRETE;
+            p += 4;
+            for (uint16_t tag : SAMPLE_TAGS)
+            {
+                PutU16(p, tag);
+                p += 2;
+            }
+            // Chunk flags 0: show the frame until the next one arrives
+            PutU32(p, std::min<uint32_t>(durationUs, 0xFFFFFF));
+            p += CHUNK_HEADER;
+        }
+        for (size_t i = next; i < next + samples; i++, p += SAMPLE_SIZE)
+        {
+            const LaserPoint& point = frame[i];
+            PutU16(p, uint16_t(point.x));
+            PutU16(p + 2, uint16_t(point.y));
+            p[4] = point.flags ? point.r : 0;
+            p[5] = point.flags ? point.g : 0;
+            p[6] = point.flags ? point.b : 0;
+        }
+        m_Sizes[count++] = size_t(p - packet);
+        next += samples;
+    } while (next < points);
+    return count;
+}
+
+void IdnSender::SendPackets(size_t count)
+{
+#ifdef _WIN32
+    for (size_t i = 0; i < count; i++)
+    {
+        int sent = send(NativeSocket(m_Socket), reinterpret_cast<const char*>(m_Buffer.data() + i * MAX_DATAGRAM), int(m_Sizes[i]), 0);
+        m_Stats.sendCalls++;
+        if (sent < 0)
+            m_Stats.sendErrors++;
+        else
+        {
+            m_Stats.packetsSent++;
+            m_Stats.bytesSent += m_Sizes[i];
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i++)
+        m_Batch->vectors[i].iov_len = m_Sizes[i];
+    size_t done = 0;
+    while (done < count)
+    {
+        int sent = sendmmsg(NativeSocket(m_Socket), m_Batch->messages.data() + done, unsigned(count - done), 0);
+        m_Stats.sendCalls++;
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // e.g. ECONNREFUSED from an earlier datagram nobody was listening for; skip this one
+            m_Stats.sendErrors++;
+            done++;
+            continue;
+        }
+        for (size_t i = done; i < done + size_t(sent); i++)
+            m_Stats.bytesSent += m_Sizes[i];
+        m_Stats.packetsSent += size_t(sent);
+        done += size_t(sent);
+    }
+#endif
+}
+
+void IdnSender::SendFrame(const LaserFrame& frame)
+{
+    if (m_Closed)
+        return;
+    if (frame.size() > m_MaxFramePoints)
+        m_Stats.truncatedFrames++;
+    size_t points = std::min(frame.size(), m_MaxFramePoints);
+    double seconds = m_PointsPerSecond > 0.0f ? double(points) / m_PointsPerSecond : 0.0;
+    auto duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    if (m_Pacing)
+    {
+        auto now = Clock::now();
+        if (m_Stats.framesSent == 0)
+            m_NextSend = now;
+        else if (now < m_NextSend)
+            std::this_thread::sleep_until(m_NextSend);
+        else if (now - m_NextSend > duration)
+        {
+            // More than a frame behind: start over rather than burst
+            m_Stats.lateFrames++;
+            m_NextSend = now;
+        }
+    }
+    else
+        m_NextSend = Clock::now();
+    SendPackets(Pack(frame, uint32_t(seconds * 1e6 + 0.5)));
+    m_NextSend += duration;
+    m_Stats.framesSent++;
+}
+
+void IdnSender::Close()
+{
+    if (m_Closed || m_Socket == -1)
+        return;
+    m_Closed = true;
+    uint8_t packet[HELLO_HEADER] = { CMD_RT_CNLMSG_CLOSE, 0, 0, 0 };
+    PutU16(packet + 2, m_Sequence++);
+#ifdef _WIN32
+    send(NativeSocket(m_Socket), reinterpret_cast<const char*>(packet), int(sizeof(packet)), 0);
+#else
+    send(NativeSocket(m_Socket), packet, sizeof(packet), 0);
+#endif
+}
+
+IdnReceiver::IdnReceiver(uint16_t port, const std::string& address) :
+    m_Batch(std::make_unique<Batch>())
+{
+    StartSockets();
+    addrinfo hints {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* local = nullptr;
+    if (getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &local) != 0 || !local)
+        throw std::runtime_error("Failed to resolve IDN listen address " + address);
+    intptr_t s = intptr_t(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    bool bound = s != -1 && bind(NativeSocket(s), local->ai_addr, int(local->ai_addrlen)) == 0;
+    freeaddrinfo(local);
+    if (!bound)
+    {
+        if (s != -1)
+            CloseSocket(s);
+        throw std::runtime_error("Failed to bind IDN receiver to " + address + ":" + std::to_string(port));
+    }
+    m_Socket = s;
+    // Room for a few large frames in case the reader falls behind; the kernel may cap it
+    int bufferSize = 4 << 20;
+    setsockopt(NativeSocket(s), SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(bufferSize));
+    sockaddr_in boundAddress {};
+    socklen_t length = sizeof(boundAddress);
+    getsockname(NativeSocket(s), reinterpret_cast<sockaddr*>(&boundAddress), &length);
+    m_Port = ntohs(boundAddress.sin_port);
+
+    m_Buffer.resize(BatchSize * RECEIVE_SLOT);
+    m_Sizes.resize(BatchSize);
+#ifndef _WIN32
+    m_Batch->messages.resize(BatchSize);
+    m_Batch->vectors.resize(BatchSize);
+    for (size_t i = 0; i < BatchSize; i++)
+    {
+        m_Batch->vectors[i] = { m_Buffer.data() + i * RECEIVE_SLOT, RECEIVE_SLOT };
+        m_Batch->messages[i] = {};
+        m_Batch->messages[i].msg_hdr.msg_iov = &m_Batch->vectors[i];
+        m_Batch->messages[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+}
+
+IdnReceiver::~IdnReceiver()
+{
+    if (m_Socket != -1)
+        CloseSocket(m_Socket);
+}
+
+bool IdnReceiver::ReceiveFrame(LaserFrame& frame, int timeoutMs)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;)
+    {
+        while (m_Next < m_Received)
+        {
+            size_t i = m_Next++;
+            if (Consume(m_Buffer.data() + i * RECEIVE_SLOT, m_Sizes[i]))
+            {
+                frame.assign(m_Assembling.begin(), m_Assembling.end());
+                m_FrameDuration = m_AssemblingDuration;
+                m_Stats.framesReceived++;
+                return true;
+            }
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (!WaitReadable(m_Socket, int(std::max<long long>(remaining, 0))))
+            return false;
+        m_Next = 0;
+        m_Received = 0;
+#ifdef _WIN32
+        // No batch receive: drain what is already queued, one datagram per call
+        while (m_Received < BatchSize && (m_Received == 0 || WaitReadable(m_Socket, 0)))
+        {
+            int size = recv(NativeSocket(m_Socket), reinterpret_cast<char*>(m_Buffer.data() + m_Received * RECEIVE_SLOT), int(RECEIVE_SLOT), 0);
+            m_Stats.receiveCalls++;
+            if (size < 0)
+                break;
+            m_Sizes[m_Received++] = size_t(size);
+        }
+#else
+        int count = recvmmsg(NativeSocket(m_Socket), m_Batch->messages.data(), unsigned(BatchSize), MSG_DONTWAIT, nullptr);
+        m_Stats.receiveCalls++;
+        for (int i = 0; i < count; i++)
+        {
+            const mmsghdr& message = m_Batch->messages[i];
+            // A cut datagram cannot be parsed; size 0 counts it as malformed
+            m_Sizes[i] = (message.msg_hdr.msg_flags & MSG_TRUNC) ? 0 : message.msg_len;
+            m_Batch->messages[i].msg_hdr.msg_flags = 0;
+        }
+        m_Received = size_t(std::max(count, 0));
+#endif
+    }
+}
+
+void IdnReceiver::DropFrame()
+{
+    if (m_InFrame)
+        m_Stats.framesDropped++;
+    m_InFrame = false;
+    m_Skipping = true;
+}
+
+bool IdnReceiver::Consume(const uint8_t* data, size_t size)
+{
+    m_Stats.packetsReceived++;
+    m_Stats.bytesReceived += size;
+    if (size < HELLO_HEADER)
+    {
+        m_Stats.malformedPackets++;
+        return false;
+    }
+    uint8_t command = data[0];
+    if (command == CMD_RT_CNLMSG_CLOSE)
+    {
+        // The next sender numbers its messages afresh
+        m_Stats.closeMessages++;
+        m_HaveSequence = false;
+        DropFrame();
+        return false;
+    }
+    // Anything else on the port (scans, service map requests) is not ours to answer
+    if (command != CMD_RT_CNLMSG && command != CMD_RT_CNLMSG_ACKREQ)
+        return false;
+    // Every realtime message is numbered, so a gap counts the datagrams lost on the way
+    uint16_t sequence = GetU16(data + 2);
+    bool gap = m_HaveSequence && sequence != uint16_t(m_LastSequence + 1);
+    if (gap)
+        m_Stats.packetsLost += uint16_t(sequence - m_LastSequence - 1);
+    m_HaveSequence = true;
+    m_LastSequence = sequence;
+    size_t total = size >= HELLO_HEADER + CHANNEL_HEADER ? GetU16(data + 4) : 0;
+    if (total < CHANNEL_HEADER || HELLO_HEADER + total > size)
+    {
+        m_Stats.malformedPackets++;
+        return false;
+    }
+    uint16_t content = GetU16(data + 6);
+    uint8_t chunk = uint8_t(content);
+    const uint8_t* p = data + HELLO_HEADER + CHANNEL_HEADER;
+    const uint8_t* end = data + HELLO_HEADER + total;
+    if (!(content & CONTENT_CHANNEL_MSG))
+        return false;
+
+    if (chunk == CHUNK_FRAME || chunk == CHUNK_FRAME_FIRST)
+    {
+        if (content & CONTENT_CONFIG_OR_LAST)
+        {
+            if (end - p < 4 || size_t(end - p) < 4 + size_t(p[0]) * 4)
+            {
+                m_Stats.malformedPackets++;
+                return false;
+            }
+            if (p[1] & CONFIG_CLOSE)
+            {
+                m_Stats.closeMessages++;
+                DropFrame();
+                return false;
+            }
+            bool layout = p[0] == TAG_WORDS;
+            for (size_t i = 0; layout && i < TAG_WORDS * 2; i++)
+                layout = GetU16(p + 4 + i * 2) == SAMPLE_TAGS[i];
+            if (!layout)
+            {
+                m_Stats.malformedPackets++;
+                return false;
+            }
+            p += 4 + size_t(p[0]) * 4;
+        }
+        if (end - p < ptrdiff_t(CHUNK_HEADER))
+        {
+            m_Stats.malformedPackets++;
+            return false;
+        }
+        DropFrame();
+        m_Skipping = false;
+        m_InFrame = true;
+        m_AssemblingDuration = GetU24(p + 1);
+        m_Assembling.clear();
+        p += CHUNK_HEADER;
+    }
+    else if (chunk == CHUNK_FRAME_SEQUEL)
+    {
+        bool last = (content & CONTENT_CONFIG_OR_LAST) != 0;
+        if (!m_InFrame)
+        {
+            // The rest of a frame whose start never arrived
+            if (last && !m_Skipping)
+                m_Stats.framesDropped++;
+            if (last)
+                m_Skipping = false;
+            return false;
+        }
+        if (gap)
+        {
+            DropFrame();
+            if (last)
+                m_Skipping = false;
+            return false;
+        }
+    }
+    else
+        return false;
+
+    size_t samples = size_t(end - p) / SAMPLE_SIZE;
+    for (size_t i = 0; i < samples; i++, p += SAMPLE_SIZE)
+    {
+        LaserPoint point;
+        point.x = int16_t(GetU16(p));
+        point.y = int16_t(GetU16(p + 2));
+        point.r = p[4];
+        point.g = p[5];
+        point.b = p[6];
+        point.flags = (point.r | point.g | point.b) ? 1 : 0;
+        m_Assembling.push_back(point);
+    }
+    bool complete = chunk == CHUNK_FRAME || (chunk == CHUNK_FRAME_SEQUEL && (content & CONTENT_CONFIG_OR_LAST));
+    if (complete)
+        m_InFrame = false;
+    return complete;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LaserFrameGenerator.h"
+
+// ILDA Digital Network output. Frames go out as IDN-Stream channel messages
+// in discrete graphic mode, one frame chunk per LaserFrame, fragmented to fit
+// an Ethernet MTU, each datagram starting with an IDN-Hello realtime header.
+// Samples are 16-bit X/Y and 8-bit R/G/B (7 bytes). IDN has no blanking bit:
+// blanked points are sent black, and the receiver treats black points as
+// blanked. The channel configuration goes with the first fragment of every
+// frame, so a receiver can join at any frame.
+
+static constexpr uint16_t IDN_PORT = 7255;
+
+// Packs frames into preallocated datagrams and sends all of a frame's
+// datagrams with one sendmmsg where available. With pacing on, SendFrame
+// waits until the previous frame has played out at the configured rate, so
+// the DAC gets frames as fast as it shows them; a sender more than a frame
+// behind restarts the schedule from now instead of bursting to catch up.
+class IdnSender
+{
+public:
+    struct Stats
+    {
+        size_t framesSent = 0;
+        size_t packetsSent = 0;
+        size_t bytesSent = 0;
+        size_t sendCalls = 0;
+        size_t sendErrors = 0;      // datagrams the socket refused; sending goes on
+        size_t truncatedFrames = 0; // frames cut to maxFramePoints
+        size_t lateFrames = 0;      // frames that missed their pacing slot
+    };
+    // Throws std::runtime_error if host does not resolve or the socket cannot be opened
+    IdnSender(const std::string& host, uint16_t port, float pointsPerSecond, size_t maxFramePoints = 65535);
+    ~IdnSender();
+    IdnSender(const IdnSender&) = delete;
+    IdnSender& operator=(const IdnSender&) = delete;
+    // Sets the scan rate; each frame's chunk lasts points / pointsPerSecond
+    void SetPointRate(float pointsPerSecond) { m_PointsPerSecond = pointsPerSecond; }
+    void SetPacing(bool pacing) { m_Pacing = pacing; }
+    void SendFrame(const LaserFrame& frame);
+    // Tells the receiver the channel is closed; further frames are dropped
+    void Close();
+    const Stats& GetStats() const { return m_Stats; }
+private:
+    // Fills the packet buffers with the frame's datagrams, returns how many
+    size_t Pack(const LaserFrame& frame, uint32_t durationUs);
+    void SendPackets(size_t count);
+
+    intptr_t m_Socket = -1;
+    float m_PointsPerSecond;
+    bool m_Pacing = true;
+    bool m_Closed = false;
+    size_t m_MaxFramePoints;
+    std::vector<uint8_t> m_Buffer; // m_MaxPackets datagrams of MAX_DATAGRAM bytes
+    std::vector<size_t> m_Sizes;
+    size_t m_MaxPackets;
+    struct Batch; // platform batch records (mmsghdr and iovec), one per datagram
+    std::unique_ptr<Batch> m_Batch;
+    uint16_t m_Sequence = 0;
+    std::chrono::steady_clock::time_point m_Start;
+    std::chrono::steady_clock::time_point m_NextSend;
+    Stats m_Stats;
+};
+
+// Receives IDN-Stream frame messages on a UDP port and reassembles the
+// fragments into LaserFrames, e.g. to feed a GalvoSimulator. Datagrams are
+// read in batches (recvmmsg where available) into preallocated buffers. A
+// frame missing a fragment, by sequence gap or by a new frame starting, is
+// dropped whole. Only the XYRGB sample layout IdnSender sends is accepted.
+class IdnReceiver
+{
+public:
+    struct Stats
+    {
+        size_t framesReceived = 0;
+        size_t framesDropped = 0;
+        size_t packetsReceived = 0;
+        size_t packetsLost = 0; // from sequence gaps
+        size_t bytesReceived = 0;
+        size_t receiveCalls = 0;
+        size_t malformedPackets = 0;
+        size_t closeMessages = 0;
+    };
+    // port 0 picks a free one (see GetPort). Throws std::runtime_error if the socket cannot be bound.
+    explicit IdnReceiver(uint16_t port, const std::string& address = "127.0.0.1");
+    ~IdnReceiver();
+    IdnReceiver(const IdnReceiver&) = delete;
+    IdnReceiver& operator=(const IdnReceiver&) = delete;
+    uint16_t GetPort() const { return m_Port; }
+    // Waits up to timeoutMs for the next complete frame; false on timeout
+    bool ReceiveFrame(LaserFrame& frame, int timeoutMs);
+    // Chunk duration of the last frame returned, in microseconds
+    uint32_t GetFrameDuration() const { return m_FrameDuration; }
+    const Stats& GetStats() const { return m_Stats; }
+
+    static constexpr size_t BatchSize = 64;
+private:
+    // Returns true once a datagram completes the frame being assembled
+    bool Consume(const uint8_t* data, size_t size);
+    void DropFrame();
+
+    intptr_t m_Socket = -1;
+    uint16_t m_Port = 0;
+    std::vector<uint8_t> m_Buffer; // BatchSize datagrams
+    std::vector<size_t> m_Sizes;
+    struct Batch;
+    std::unique_ptr<Batch> m_Batch;
+    size_t m_Received = 0; // datagrams in the buffer
+    size_t m_Next = 0;     // next one to consume
+    LaserFrame m_Assembling;
+    bool m_InFrame = false;
+    bool m_Skipping = false; // a dropped frame's remaining fragments are still arriving
+    uint16_t m_LastSequence = 0;
+    bool m_HaveSequence = false;
+    uint32_t m_AssemblingDuration = 0;
+    uint32_t m_FrameDuration = 0;
+    Stats m_Stats;
+};
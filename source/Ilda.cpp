@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Ilda.h"
+#include "LaserFrameGenerator.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <windows.h>
+#undef max
+#undef min
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+static constexpr size_t HEADER_SIZE = 32;
+static constexpr size_t RECORD_SIZE_FORMAT5 = 8;
+static constexpr size_t MAX_RECORDS = 65535;
+static constexpr uint8_t STATUS_LAST_POINT = 0x80;
+static constexpr uint8_t STATUS_BLANKED = 0x40;
+
+static void PutU16(uint8_t* p, uint16_t v)
+{
+    p[0] = uint8_t(v >> 8);
+    p[1] = uint8_t(v);
+}
+
+static uint16_t GetU16(const uint8_t* p)
+{
+    return uint16_t((p[0] << 8) | p[1]);
+}
+
+static void EncodeHeader(uint8_t* p, uint8_t format, uint16_t records, uint16_t frameNumber, uint16_t totalFrames)
+{
+    std::memset(p, 0, HEADER_SIZE);
+    std::memcpy(p, "ILDA", 4);
+    p[7] = format;
+    std::memcpy(p + 8, "LaserEmu", 8);  // frame name
+    std::memcpy(p + 16, "LaserEmu", 8); // company name
+    PutU16(p + 24, records);
+    PutU16(p + 26, frameNumber);
+    PutU16(p + 28, totalFrames);
+    p[30] = 0; // projector number
+}
+
+static size_t RecordSize(uint8_t format)
+{
+    switch (format)
+    {
+    case 0: return 8;  // 3D indexed
+    case 1: return 6;  // 2D indexed
+    case 2: return 3;  // palette
+    case 4: return 10; // 3D true color
+    case 5: return 8;  // 2D true color
+    default: return 0;
+    }
+}
+
+static bool WriteAll(int file, const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+#ifdef _WIN32
+        int written = _write(file, data, unsigned(std::min<size_t>(size, 1u << 30)));
+#else
+        ssize_t written = write(file, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+#endif
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= size_t(written);
+    }
+    return true;
+}
+
+IldaWriter::IldaWriter(const std::string& path) : m_Path(path)
+{
+#ifdef _WIN32
+    m_File = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    m_File = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (m_File < 0)
+        throw std::runtime_error("Failed to create ILDA file " + path);
+    m_Thread = std::thread(&IldaWriter::WriterLoop, this);
+}
+
+IldaWriter::~IldaWriter()
+{
+    Finish();
+}
+
+void IldaWriter::WriteFrame(const LaserFrame& frame)
+{
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Closed)
+            return;
+        if (!m_FreeBuffers.empty())
+        {
+            buffer = std::move(m_FreeBuffers.back());
+            m_FreeBuffers.pop_back();
+        }
+    }
+
+    // A zero-record header means end of file, so an empty frame is stored as one
+    // blanked point where the last frame ended, keeping every later frame in step
+    const LaserPoint parked { m_LastPoint.x, m_LastPoint.y, 0, 0, 0, 0 };
+    const LaserPoint* points = frame.empty() ? &parked : frame.data();
+    size_t records = frame.empty() ? 1 : std::min(frame.size(), MAX_RECORDS);
+    buffer.resize(HEADER_SIZE + records * RECORD_SIZE_FORMAT5);
+    uint8_t* p = buffer.data();
+    // Total frames is unknown while streaming; Close() patches it in
+    EncodeHeader(p, 5, uint16_t(records), m_FrameNumber, 0);
+    p += HEADER_SIZE;
+    for (size_t i = 0; i < records; i++, p += RECORD_SIZE_FORMAT5)
+    {
+        const LaserPoint& point = points[i];
+        PutU16(p, uint16_t(point.x));
+        PutU16(p + 2, uint16_t(point.y));
+        uint8_t status = point.flags ? 0 : STATUS_BLANKED;
+        if (i + 1 == records)
+            status |= STATUS_LAST_POINT;
+        p[4] = status;
+        p[5] = point.b;
+        p[6] = point.g;
+        p[7] = point.r;
+    }
+
+    m_LastPoint = points[records - 1];
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (records < frame.size())
+        m_Stats.truncatedFrames++;
+    m_HeaderOffsets.push_back(m_FileOffset);
+    m_FileOffset += buffer.size();
+    m_FrameNumber++;
+    m_Queue.push_back(std::move(buffer));
+    m_Stats.maxQueued = std::max(m_Stats.maxQueued, m_Queue.size());
+    m_QueueReady.notify_one();
+}
+
+void IldaWriter::WriterLoop()
+{
+    std::vector<std::vector<uint8_t>> pending;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_QueueReady.wait(lock, [this] () { return m_Stop || !m_Queue.empty(); });
+            if (m_Queue.empty() && m_Stop)
+                return;
+            pending.swap(m_Queue);
+        }
+        size_t calls = 0;
+        size_t written = m_Failed ? 0 : WriteBuffers(pending, calls);
+        if (written < pending.size())
+            m_Failed = true;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stats.writeCalls += calls;
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            if (i < written)
+            {
+                m_Stats.framesWritten++;
+                m_Stats.bytesWritten += pending[i].size();
+            }
+            else
+                m_Stats.failedFrames++;
+            m_FreeBuffers.push_back(std::move(pending[i]));
+        }
+        pending.clear();
+    }
+}
+
+size_t IldaWriter::WriteBuffers(std::vector<std::vector<uint8_t>>& buffers, size_t& calls)
+{
+#ifdef _WIN32
+    for (size_t i = 0; i < buffers.size(); i++)
+    {
+        calls++;
+        if (!WriteAll(m_File, buffers[i].data(), buffers[i].size()))
+            return i;
+    }
+    return buffers.size();
+#else
+    // Gather as many frames as the kernel takes in one writev, finish partial writes by hand
+    size_t index = 0;
+    while (index < buffers.size())
+    {
+        iovec vectors[64];
+        int count = 0;
+        for (size_t i = index; i < buffers.size() && count < 64 && count < IOV_MAX; i++, count++)
+        {
+            vectors[count].iov_base = buffers[i].data();
+            vectors[count].iov_len = buffers[i].size();
+        }
+        ssize_t written = writev(m_File, vectors, count);
+        calls++;
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return index;
+        size_t remaining = size_t(written);
+        for (int i = 0; i < count; i++, index++)
+        {
+            size_t size = buffers[index].size();
+            if (remaining >= size)
+            {
+                remaining -= size;
+                continue;
+            }
+            calls++;
+            if (!WriteAll(m_File, buffers[index].data() + remaining, size - remaining))
+                return index;
+            remaining = 0;
+        }
+    }
+    return buffers.size();
+#endif
+}
+
+void IldaWriter::Close()
+{
+    if (!Finish())
+        throw std::runtime_error("Failed to write ILDA file " + m_Path);
+}
+
+bool IldaWriter::Finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Closed)
+            return !m_Failed;
+        m_Closed = true;
+        m_Stop = true;
+    }
+    m_QueueReady.notify_one();
+    m_Thread.join();
+
+    uint8_t end[HEADER_SIZE];
+    EncodeHeader(end, 5, 0, m_FrameNumber, m_FrameNumber);
+    if (!WriteAll(m_File, end, HEADER_SIZE))
+        m_Failed = true;
+
+    // Patch the total frame count into every frame header
+    uint8_t total[2];
+    PutU16(total, uint16_t(std::min<size_t>(m_HeaderOffsets.size(), 0xFFFF)));
+    for (uint64_t offset : m_HeaderOffsets)
+    {
+#ifdef _WIN32
+        bool patched = _lseeki64(m_File, int64_t(offset + 28), SEEK_SET) >= 0 && _write(m_File, total, 2) == 2;
+#else
+        ssize_t written;
+        do
+            written = pwrite(m_File, total, 2, off_t(offset + 28));
+        while (written < 0 && errno == EINTR);
+        bool patched = written == 2;
+#endif
+        if (!patched)
+            m_Failed = true;
+    }
+#ifdef _WIN32
+    if (_close(m_File) != 0)
+        m_Failed = true;
+#else
+    if (close(m_File) != 0)
+        m_Failed = true;
+#endif
+    m_File = -1;
+    return !m_Failed;
+}
+
+IldaWriter::Stats IldaWriter::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+IldaReader::IldaReader(const std::string& path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open ILDA file " + path);
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    m_FileHandle = file;
+    m_Size = size_t(size.QuadPart);
+    if (m_Size == 0)
+        return;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        throw std::runtime_error("Failed to map ILDA file " + path);
+    m_MappingHandle = mapping;
+    m_Data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        throw std::runtime_error("Failed to open ILDA file " + path);
+    struct stat info;
+    if (fstat(file, &info) != 0)
+    {
+        close(file);
+        throw std::runtime_error("Failed to stat ILDA file " + path);
+    }
+    m_Size = size_t(info.st_size);
+    if (m_Size > 0)
+    {
+        void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data != MAP_FAILED)
+        {
+            m_Data = static_cast<const uint8_t*>(data);
+            madvise(data, m_Size, MADV_SEQUENTIAL);
+        }
+    }
+    close(file);
+#endif
+    if (m_Size > 0 && !m_Data)
+        throw std::runtime_error("Failed to map ILDA file " + path);
+}
+
+IldaReader::~IldaReader()
+{
+#ifdef _WIN32
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_MappingHandle)
+        CloseHandle(m_MappingHandle);
+    if (m_FileHandle)
+        CloseHandle(m_FileHandle);
+#else
+    if (m_Data)
+        munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+}
+
+bool IldaReader::NextFrame(LaserFrame& frame)
+{
+    while (m_Offset + HEADER_SIZE <= m_Size)
+    {
+        const uint8_t* header = m_Data + m_Offset;
+        if (std::memcmp(header, "ILDA", 4) != 0)
+            return false;
+        uint8_t format = header[7];
+        size_t records = GetU16(header + 24);
+        size_t recordSize = RecordSize(format);
+        if (records == 0 || recordSize == 0)
+            return false;
+        const uint8_t* p = header + HEADER_SIZE;
+        size_t sectionSize = HEADER_SIZE + records * recordSize;
+        if (m_Offset + sectionSize > m_Size)
+            return false;
+        m_Offset += sectionSize;
+        if (format != 5)
+            continue;
+
+        frame.resize(records);
+        for (size_t i = 0; i < records; i++, p += RECORD_SIZE_FORMAT5)
+        {
+            LaserPoint& point = frame[i];
+            point.x = int16_t(GetU16(p));
+            point.y = int16_t(GetU16(p + 2));
+            point.flags = (p[4] & STATUS_BLANKED) ? 0 : 1;
+            point.b = p[5];
+            point.g = p[6];
+            point.r = p[7];
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LaserFrameGenerator.h"
+
+// ILDA Image Data Transfer Format, format 5 (2D true color).
+// Points are stored as-is: X/Y in DAC units, LaserPoint::flags == 0 sets the
+// blanking bit. Reading back a written file gives the same LaserFrames, except
+// that frames are limited to 65535 points by the format and an empty frame
+// comes back as a single blanked point where the frame before it ended.
+
+// Streams frames to disk from a background thread. WriteFrame only encodes
+// into a recycled buffer and queues it, so the caller never waits on the disk.
+// The writer thread drains every queued buffer with one vectored write.
+// A failed write (disk full, say) drops that frame and every later one; Close
+// reports it. WriteFrame and Close must be called from the same thread.
+class IldaWriter
+{
+public:
+    struct Stats
+    {
+        size_t framesWritten = 0;   // frames that reached the file whole
+        size_t bytesWritten = 0;
+        size_t failedFrames = 0;    // frames lost to write errors
+        size_t truncatedFrames = 0; // frames cut to the 65535 point limit
+        size_t writeCalls = 0;
+        size_t maxQueued = 0;
+    };
+    // Throws std::runtime_error if the file cannot be created
+    explicit IldaWriter(const std::string& path);
+    ~IldaWriter();
+    IldaWriter(const IldaWriter&) = delete;
+    IldaWriter& operator=(const IldaWriter&) = delete;
+    void WriteFrame(const LaserFrame& frame);
+    // Flushes the queue, writes the end-of-file header, fills in the total frame count and closes.
+    // Throws std::runtime_error if any write failed.
+    void Close();
+    Stats GetStats();
+private:
+    void WriterLoop();
+    // Returns how many of the buffers were written whole; counts the write calls made
+    size_t WriteBuffers(std::vector<std::vector<uint8_t>>& buffers, size_t& calls);
+    // Close without throwing; false if any write failed
+    bool Finish();
+    std::string m_Path;
+    int m_File;
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_QueueReady;
+    std::vector<std::vector<uint8_t>> m_Queue;
+    std::vector<std::vector<uint8_t>> m_FreeBuffers;
+    std::vector<uint64_t> m_HeaderOffsets; // file offset of every frame header, patched by Close()
+    uint64_t m_FileOffset = 0;
+    uint16_t m_FrameNumber = 0;
+    LaserPoint m_LastPoint {}; // end of the last frame written, for empty frames
+    bool m_Stop = false;
+    bool m_Closed = false;
+    bool m_Failed = false; // set by the writer thread, read after it is joined
+    Stats m_Stats;
+};
+
+// Memory-maps an ILDA file and decodes format 5 frames. Sections in other
+// formats are skipped.
+class IldaReader
+{
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    explicit IldaReader(const std::string& path);
+    ~IldaReader();
+    IldaReader(const IldaReader&) = delete;
+    IldaReader& operator=(const IldaReader&) = delete;
+    // Decodes the next frame into frame; false at the end of the file
+    bool NextFrame(LaserFrame& frame);
+    void Rewind() { m_Offset = 0; }
+private:
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+    size_t m_Offset = 0;
+#ifdef _WIN32
+    void* m_FileHandle = nullptr;
+    void* m_MappingHandle = nullptr;
+#endif
+};
@@ -33,27 +33,27 @@ void InputManager::HandleEvent(const MSG& msg)
 void InputManager::Bind(const std::string& action, int vk)
 {
     actionKeys[action] = vk;
+    states[action].key = vk;
 }
 
 void InputManager::Update(GameContext& context)
 {
-    for (auto& [name, key] : actionKeys)
+    // Walks the states directly and emits by interned ID, so no action name is hashed per frame
+    for (auto& [name, state] : states)
     {
-        bool isDown = GetAsyncKeyState(key) & 0x8000;
+        bool isDown = GetAsyncKeyState(state.key) & 0x8000;
 
-        states[name].previous = states[name].current;
-        states[name].current = isDown;
+        state.previous = state.current;
+        state.current = isDown;
+        if (state.event == EventManager::InvalidEvent)
+            state.event = context.events.Intern(name);
+        if (state.current)
+            context.events.Queue(state.event);
     }
     for (int vk = 0; vk < 256; ++vk)
         curr[vk] = (GetAsyncKeyState(vk) & 0x8000) != 0;
 
-    for (auto& [actionName, key] : actionKeys)
-    {
-        if (IsAction(actionName))
-        {
-            context.events.Emit(actionName);
-        }
-    }
+    context.events.Dispatch();
 }
 
 
@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include <string>
 #include <Windows.h>
+#include "EventManager.h"
 #include "Point2D.h"
 
 class GameContext;
@@ -33,6 +34,8 @@ private:
     {
         bool current = false;
         bool previous = false;
+        int key = 0;
+        EventManager::EventId event = EventManager::InvalidEvent; // interned on the first Update
     };
     std::array<bool, 256> curr {};
     std::array<bool, 256> prev {};
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 #include <algorithm>
 #include <cmath>
@@ -52,6 +53,19 @@ public:
         return HSVtoRGB(hue, sat, val);
     }
 
+    // Same gradient running from t=1 to t=0
+    LaserColor Reversed() const noexcept
+    {
+        return LaserColor(m_h1, m_h0, m_s1, m_s0, m_v1, m_v0);
+    }
+
+    bool IsSolid() const noexcept
+    {
+        return m_h0 == m_h1 && m_s0 == m_s1 && m_v0 == m_v1;
+    }
+
+    bool operator==(const LaserColor& other) const noexcept = default;
+
 private:
     float m_h0, m_h1;   // Hue 0360
     float m_s0, m_s1;   // Saturation 01
@@ -142,3 +156,69 @@ private:
             H += 360.0f;
     }
 };
+
+// A LaserColor baked into RGB8 at fixed steps of t, so emitting a point is one
+// table read instead of the HSV conversion. Solid colors bake a single entry
+// and are exact; gradients are within one level per channel of getRGB(t).
+class LaserColorTable
+{
+public:
+    static constexpr int Resolution = 1024;
+    struct ErrorReport
+    {
+        int maxError = 0;         // worst channel difference from getRGB(t)
+        float meanError = 0.0f;
+        int samples = 0;
+    };
+    LaserColorTable() = default;
+    explicit LaserColorTable(const LaserColor& color) { Bake(color); }
+
+    void Bake(const LaserColor& color) noexcept
+    {
+        m_Color = color;
+        m_Solid = color.IsSolid();
+        if (m_Solid)
+        {
+            // getRGB(t) does not depend on t here, and getRGB() skips the hue wrap it applies
+            m_Table[0] = color.getRGB(0.0f);
+            return;
+        }
+        for (int i = 0; i <= Resolution; i++)
+            m_Table[i] = color.getRGB(float(i) / float(Resolution));
+    }
+
+    const LaserColor& GetColor() const noexcept { return m_Color; }
+    bool IsSolid() const noexcept { return m_Solid; }
+
+    LaserColor::RGB8 Lookup(float t) const noexcept
+    {
+        if (m_Solid)
+            return m_Table[0];
+        int index = int(std::clamp(t, 0.0f, 1.0f) * float(Resolution) + 0.5f);
+        return m_Table[index];
+    }
+
+    // Compares Lookup against the exact conversion at samples evenly spaced t
+    ErrorReport MeasureError(int samples = 65536) const noexcept
+    {
+        ErrorReport report;
+        long long sum = 0;
+        for (int i = 0; i < samples; i++)
+        {
+            float t = float(i) / float(samples - 1);
+            LaserColor::RGB8 exact = m_Color.getRGB(t);
+            LaserColor::RGB8 baked = Lookup(t);
+            int error = std::max({ std::abs(exact.r - baked.r), std::abs(exact.g - baked.g), std::abs(exact.b - baked.b) });
+            report.maxError = std::max(report.maxError, error);
+            sum += error;
+            report.samples++;
+        }
+        report.meanError = report.samples ? float(double(sum) / double(report.samples)) : 0.0f;
+        return report;
+    }
+
+private:
+    LaserColor m_Color;
+    bool m_Solid = true;
+    std::array<LaserColor::RGB8, Resolution + 1> m_Table {};
+};
@@ -4,11 +4,15 @@
 #include <cstdint>
 #include <cstdlib>
 #include <vector>
+#include <memory>
+#include <memory_resource>
 #include "LaserFrameGenerator.h"
 #include "Point2D.h"
 #include "LaserColor.h"
+#include "DistortionCorrector.h"
+#include "PointKernel.h"
+#include "Profiler.h"
 
-static float constexpr DEG_TO_RAD = 0.01745329251994f;
 constexpr float PI = 3.14159265358979323846f;
 constexpr float PI2 = 2.0f * PI;
 
@@ -17,18 +21,16 @@ static float GalvoEaseOut(float t)
     return (t ==  0.0f) ? 0.0f : 1.0f - float(std::pow(2, 10 * t - 10));
 }
 
-LaserFrameGenerator::LaserFrameGenerator(float maxextent, float maxAngle) : m_MaxAngle(maxAngle), m_MaxValue(32767 * maxextent), m_averagePointSpacing(0.025f), m_prev(Point2D()) {}
+LaserFrameGenerator::LaserFrameGenerator(float maxextent, float maxAngle) : m_prev(Point2D()), m_MaxAngle(maxAngle), m_MaxValue(32767 * maxextent), m_averagePointSpacing(0.025f), m_PointSpacing(0.025f), m_Corrector(maxAngle) {}
 
-Point2D LaserFrameGenerator::LerpTo(Point2D next, float t) const
+void LaserFrameGenerator::NewFrame()
 {
-    Point2D d = next - m_prev;
-    return m_prev + (d * t);
-}
-
-void LaserFrameGenerator::ClampPoint2D(Point2D& p)
-{
-    p.x = std::clamp(p.x, -m_MaxValue, m_MaxValue);
-    p.y = std::clamp(p.y, -m_MaxValue, m_MaxValue);
+    m_FramePolicy.Prepare(m_Frame);
+    m_Commands.clear();
+    m_ShapePoints.clear();
+    m_FrameStart = m_prev;
+    m_FrameStartSize = m_Frame.size();
+    m_DrawCalls = DrawCalls {};
 }
 
 float LaserFrameGenerator::ConvertAngle(const float angle) const
@@ -38,100 +40,279 @@ float LaserFrameGenerator::ConvertAngle(const float angle) const
 
 void LaserFrameGenerator::DistortionCorrection(Point2D& p) const 
 {
-    // Input: x,y in [-1,1]
-    float r = sqrtf(p.x * p.x + p.y * p.y);
-    float th = atan2f(p.y, p.x);
+    m_Corrector.Apply(p);
+}
+
+void LaserFrameGenerator::SetFrameMemory(std::pmr::memory_resource* resource)
+{
+    LaserFrame frame(resource ? resource : std::pmr::get_default_resource());
+    frame.reserve(m_Frame.capacity());
+    frame.assign(m_Frame.begin(), m_Frame.end());
+    // pmr containers never propagate their resource on assignment or swap, so rebuild in place
+    std::destroy_at(&m_Frame);
+    std::construct_at(&m_Frame, std::move(frame));
+}
 
-    // normalized radius -> angle space
-    float angleDeg = r * m_MaxAngle;
+DistortionCorrector::ErrorReport LaserFrameGenerator::GetCorrectionErrorReport() const
+{
+    return m_Corrector.MeasureError(m_MaxValue);
+}
 
-    // *** distortion correction ***
-    float correctedAngleDeg = atanf(angleDeg * DEG_TO_RAD) / DEG_TO_RAD;
+void LaserFrameGenerator::PrepareBatch(int count)
+{
+    if (int(m_BatchT.size()) < count)
+    {
+        m_BatchT.resize(count);
+        m_BatchX.resize(count);
+        m_BatchY.resize(count);
+    }
+}
 
-    // angle space -> back to normalized
-    float correctedR = correctedAngleDeg / m_MaxAngle;
+void LaserFrameGenerator::EmitBatch(int count, const LaserColor& color, uint8_t flags, int first)
+{
+    float* x = m_BatchX.data() + first;
+    float* y = m_BatchY.data() + first;
+    const float* t = m_BatchT.data() + first;
+    if (m_Capture)
+    {
+        // Local-space points for the template; correction and quantization happen on replay
+        m_Capture->runs.push_back(ShapeTemplate::Run { int(m_Capture->x.size()), count, flags, false, color == m_CaptureColor, color });
+        m_Capture->x.insert(m_Capture->x.end(), x, x + count);
+        m_Capture->y.insert(m_Capture->y.end(), y, y + count);
+        m_Capture->t.insert(m_Capture->t.end(), t, t + count);
+        m_Capture->points += count;
+        return;
+    }
+    // Grow the frame once for the whole run, then fill it in place
+    size_t base = m_Frame.size();
+    m_Frame.resize(base + count);
+    LaserPoint* out = m_Frame.data() + base;
+    m_Corrector.ApplyBatch(x, y, count);
+    PointKernel::Quantize(x, y, count, m_MaxValue, out);
+    const LaserColorTable* table = m_UseColorTables ? ColorTable(color, count) : nullptr;
+    if (table)
+        PointKernel::Colorize(*table, t, count, flags, out);
+    else
+        PointKernel::Colorize(color, t, count, flags, out);
+}
 
-    // build corrected coordinate
-    p.x = correctedR * cosf(th);
-    p.y = correctedR * sinf(th);
+const LaserColorTable* LaserFrameGenerator::ColorTable(const LaserColor& color, int count)
+{
+    int slot = m_LastColorTable;
+    if (m_ColorTablesUsed == 0 || !(m_ColorCache[slot].color == color))
+    {
+        slot = -1;
+        for (int i = 0; i < m_ColorTablesUsed && slot < 0; i++)
+        {
+            if (m_ColorCache[i].color == color)
+                slot = i;
+        }
+        if (slot < 0)
+        {
+            // Miss: take a free slot, otherwise the least recently used
+            if (m_ColorTablesUsed < ColorCacheSize)
+                slot = m_ColorTablesUsed++;
+            else
+            {
+                slot = 0;
+                for (int i = 1; i < ColorCacheSize; i++)
+                {
+                    if (m_ColorCache[i].lastUse < m_ColorCache[slot].lastUse)
+                        slot = i;
+                }
+            }
+            m_ColorCache[slot] = ColorCacheEntry { color };
+        }
+        m_LastColorTable = slot;
+    }
+    ColorCacheEntry& entry = m_ColorCache[slot];
+    entry.lastUse = ++m_ColorUses;
+    if (!entry.baked)
+    {
+        // A solid color bakes a single entry; a gradient waits until the bake would have paid for itself
+        entry.exactPoints += count;
+        if (!color.IsSolid() && entry.exactPoints <= LaserColorTable::Resolution)
+            return nullptr;
+        m_ColorTables[slot].Bake(color);
+        entry.baked = true;
+    }
+    return &m_ColorTables[slot];
+}
+
+void LaserFrameGenerator::EmitDwell(Point2D p, int count, const LaserColor& color, uint8_t flags)
+{
+    PrepareBatch(1);
+    m_BatchX[0] = p.x;
+    m_BatchY[0] = p.y;
+    m_BatchT[0] = 1.0f;
+    EmitBatch(1, color, flags);
+    if (m_Capture)
+    {
+        m_Capture->runs.back().dwell = true;
+        m_Capture->runs.back().count = count;
+        m_Capture->points += count - 1;
+        return;
+    }
+    m_Frame.back().b = 255;
+    m_Frame.insert(m_Frame.end(), count - 1, m_Frame.back());
+}
+
+void LaserFrameGenerator::BrakingT(int steps, int brakingPoints)
+{
+    float rampdownsteps = float(steps - 1);
+    float baseT = rampdownsteps / float(steps);
+    PrepareBatch(brakingPoints + 1);
+    for (int i = 0; i <= brakingPoints; i++)
+    {
+        float t = float(i) / float(brakingPoints);
+        m_BatchT[i] = baseT + (1.0f - baseT) * GalvoEaseOut(t);
+    }
+}
+
+int LaserFrameGenerator::CountLinePoints(float length, PointSharpness pointsharpness) const
+{
+    int steps = std::max<int>(1, static_cast<int>(length / m_PointSpacing));
+    // SHARP: steps base points, then the braking ramp and dwell
+    return (pointsharpness == PointSharpness::SHARP) ? steps + m_BrakingPoints + 1 + m_DwellPoints : steps + 1;
+}
+
+void LaserFrameGenerator::SetPointBudget(float pointsPerSecond, float framesPerSecond, float maxSpacingScale)
+{
+    m_PointBudget = std::max(1, static_cast<int>(pointsPerSecond / framesPerSecond));
+    m_MaxSpacingScale = std::max(1.0f, maxSpacingScale);
+}
+
+int LaserFrameGenerator::CountRecordedPoints(float spacing, int brakingPoints, int dwellPoints) const
+{
+    int points = 0;
+    for (const Command& command : m_Commands)
+    {
+        if (command.type == Command::Type::SHAPE)
+        {
+            points += int(command.length);
+            continue;
+        }
+        int steps = std::max<int>(1, static_cast<int>(command.length / spacing));
+        points += (command.sharpness == PointSharpness::SHARP) ? steps + brakingPoints + 1 + dwellPoints : steps + 1;
+    }
+    return points;
+}
+
+void LaserFrameGenerator::EndFrame()
+{
+    PROFILE_SCOPE("EndFrame");
+    if (m_PointBudget <= 0 || m_Replaying)
+        return;
+    const int budget = m_PointBudget;
+    const float nominal = m_averagePointSpacing;
+    const float widest = nominal * m_MaxSpacingScale;
+    m_BudgetStats = BudgetStats {};
+    m_BudgetStats.budget = budget;
+    // Braking/dwell levels in order of preference; corners only lose dwell once spacing alone can't fit
+    static const int levels[][2] = { { 6, 4 }, { 5, 3 }, { 4, 2 }, { 3, 1 }, { 2, 1 } };
+    m_BudgetStats.requestedPoints = CountRecordedPoints(nominal, levels[0][0], levels[0][1]);
+    float spacing = nominal;
+    int braking = levels[0][0];
+    int dwell = levels[0][1];
+    if (m_BudgetStats.requestedPoints > budget)
+    {
+        spacing = widest;
+        braking = levels[4][0];
+        dwell = levels[4][1];
+        for (const auto& level : levels)
+        {
+            if (CountRecordedPoints(widest, level[0], level[1]) > budget)
+                continue;
+            braking = level[0];
+            dwell = level[1];
+            // Point count only falls as spacing grows, so bisect for the tightest spacing that fits
+            float lo = nominal;
+            float hi = widest;
+            for (int i = 0; i < 16; i++)
+            {
+                float mid = 0.5f * (lo + hi);
+                if (CountRecordedPoints(mid, braking, dwell) > budget)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            spacing = hi;
+            break;
+        }
+    }
+
+    m_PointSpacing = spacing;
+    m_BrakingPoints = braking;
+    m_DwellPoints = dwell;
+    m_Replaying = true;
+    m_prev = m_FrameStart;
+    for (const Command& command : m_Commands)
+    {
+        switch (command.type)
+        {
+        case Command::Type::LINE:
+            LineTo(command.next, command.state, command.sharpness, command.color);
+            break;
+        case Command::Type::ARC:
+            ArcTo(command.center, command.next, command.state, command.sharpness, command.color, command.direction);
+            break;
+        case Command::Type::SHAPE:
+            DrawPoints(&m_ShapePoints[command.shapeFirst], command.shapeSize, command.t, command.color);
+            break;
+        }
+    }
+    m_Replaying = false;
+    m_PointSpacing = nominal;
+    m_BrakingPoints = levels[0][0];
+    m_DwellPoints = levels[0][1];
+
+    m_BudgetStats.emittedPoints = int(m_Frame.size() - m_FrameStartSize);
+    m_BudgetStats.spacing = spacing;
+    m_BudgetStats.brakingPoints = braking;
+    m_BudgetStats.dwellPoints = dwell;
+    m_Commands.clear();
+    m_ShapePoints.clear();
 }
 
 void LaserFrameGenerator::LineTo(Point2D next, LaserState laserstate, PointSharpness pointsharpness, LaserColor color)
 {
+    if (!m_Replaying)
+        m_DrawCalls.lines++;
     //next *= (m_MaxValue);
     Point2D d = m_prev - next;
     const float length = d.Length();
-	const float segmentLength = length / m_averagePointSpacing;
+    if (Recording())
+    {
+        m_Commands.push_back(Command { Command::Type::LINE, next, Point2D(), laserstate, pointsharpness, Arc::CLOCKWISE, color, length, 0, 0, 0.0f });
+        m_prev = next;
+        return;
+    }
+	const float segmentLength = length / m_PointSpacing;
     int steps = std::max<int>(1, static_cast<int>(segmentLength));
 	int basesteps = (pointsharpness == PointSharpness::SHARP) ? steps - 1 : steps;
-    for (int i = 0; i <= basesteps; i++)
-    {
-        float t = float(i) / float(steps);
-        Point2D ipoint = LerpTo(next, t);
-        DistortionCorrection(ipoint);
-		ipoint *= m_MaxValue;
-        ClampPoint2D(ipoint);
-        LaserPoint p {};
-        p.x = (int16_t)ipoint.x;
-        p.y = (int16_t)ipoint.y;
-        // Color interpolation
-        LaserColor::RGB8 colors = color.getRGB(t);
-        p.r = colors.r;
-        p.g = colors.g;
-        p.b = colors.b;
-        p.flags = (laserstate == LaserState::ON) ? true : false;
-        m_Frame.push_back(p);
-    }
+    const uint8_t flags = (laserstate == LaserState::ON) ? 1 : 0;
+    const Point2D delta = next - m_prev;
+    const int count = basesteps + 1;
+    PrepareBatch(count);
+    PointKernel::StepT(0, count, steps, m_BatchT.data());
+    PointKernel::Lerp(m_prev, delta, m_BatchT.data(), count, m_BatchX.data(), m_BatchY.data());
+    EmitBatch(count, color, flags);
     // Dwell, add a few extra points to ensure laser lingers
     if (pointsharpness == PointSharpness::SHARP)
     {
-	    float rampdownsteps = float(steps - 1);
-	    float baseT = rampdownsteps / float(steps);
-		const int brakingPoints =  6;
-        for (int i = 0; i <= brakingPoints; i++)
-        {
-			float t = float(i) / float(brakingPoints);
-			float easedT = baseT + (1.0f - baseT) * GalvoEaseOut(t);
-            Point2D ipoint = LerpTo(next, easedT);
-            DistortionCorrection(ipoint);
-            ipoint *= m_MaxValue;
-            ClampPoint2D(ipoint);
-            LaserPoint p {};
-            p.x = (int16_t)ipoint.x;
-            p.y = (int16_t)ipoint.y;
-            LaserColor::RGB8 colors = color.getRGB(easedT);
-            p.r = colors.r;
-            p.g = colors.g;
-            p.b = colors.b;
-            p.flags = (laserstate == LaserState::ON) ? true : false;
-            m_Frame.push_back(p);
-        }
-        const int dwellPoints = 4;
-        for (int i = 0; i < dwellPoints; i++)
-        {
-            Point2D ipoint = next;
-            DistortionCorrection(ipoint);
-            ipoint *= m_MaxValue;
-            ClampPoint2D(ipoint);
-            LaserPoint p {};
-            p.x = (int16_t)ipoint.x;
-            p.y = (int16_t)ipoint.y;
-            LaserColor::RGB8 colors = color.getRGB(1.0);
-            p.r = colors.r;
-            p.g = colors.g;
-            p.b = 255;
-            p.flags = (laserstate == LaserState::ON) ? true : false;
-            m_Frame.push_back(p);
-        }
+		const int brakingPoints = m_BrakingPoints;
+        BrakingT(steps, brakingPoints);
+        PointKernel::Lerp(m_prev, delta, m_BatchT.data(), brakingPoints + 1, m_BatchX.data(), m_BatchY.data());
+        EmitBatch(brakingPoints + 1, color, flags);
+        EmitDwell(next, m_DwellPoints, color, flags);
     }
     m_prev = next;
 }
 
-void LaserFrameGenerator::ArcTo(Point2D center, Point2D next, LaserState laserstate, PointSharpness pointsharpness, LaserColor color, Arc direction)
+float LaserFrameGenerator::ArcSweep(Point2D center, Point2D next, Arc direction) const
 {
 	Point2D radiusVecPrev = m_prev - center;
     Point2D radiusVecNext = next - center;
-	float radius = radiusVecPrev.Length();
 	float startAngle = std::atan2(radiusVecPrev.y, radiusVecPrev.x);
     float endAngle = std::atan2(radiusVecNext.y, radiusVecNext.x);
 	float sweepangle = endAngle - startAngle;
@@ -145,94 +326,135 @@ void LaserFrameGenerator::ArcTo(Point2D center, Point2D next, LaserState laserst
         if (sweepangle <= 0.0f)
             sweepangle += PI2;
 	}
+    return sweepangle;
+}
+
+void LaserFrameGenerator::ArcTo(Point2D center, Point2D next, LaserState laserstate, PointSharpness pointsharpness, LaserColor color, Arc direction)
+{
+    if (!m_Replaying)
+    {
+        m_DrawCalls.arcs++;
+    }
+	Point2D radiusVecPrev = m_prev - center;
+	float radius = radiusVecPrev.Length();
+	float sweepangle = ArcSweep(center, next, direction);
 	float arclength = std::abs(sweepangle * radius);
-	const float segmentLength = arclength / m_averagePointSpacing;
+    if (Recording())
+    {
+        m_Commands.push_back(Command { Command::Type::ARC, next, center, laserstate, pointsharpness, direction, color, arclength, 0, 0, 0.0f });
+        m_prev = radiusVecPrev.Rotate(sweepangle) + center;
+        return;
+    }
+	const float segmentLength = arclength / m_PointSpacing;
 	int steps = std::max<int>(1, static_cast<int>(segmentLength));
     int basesteps = (pointsharpness == PointSharpness::SHARP) ? steps - 1 : steps;
-    for (int i = 0; i <= basesteps; i++)
-    {
-        float t = float(i) / float(steps);
-		Point2D ipoint = radiusVecPrev.Rotate(sweepangle * t) + center;
-        DistortionCorrection(ipoint);
-        ipoint *= m_MaxValue;
-        ClampPoint2D(ipoint);
-        LaserPoint p {};
-        p.x = (int16_t)ipoint.x;
-        p.y = (int16_t)ipoint.y;
-        // Color interpolation
-        LaserColor::RGB8 colors = color.getRGB(t);
-        p.r = colors.r;
-        p.g = colors.g;
-        p.b = colors.b;
-        p.flags = (laserstate == LaserState::ON) ? true : false;
-        m_Frame.push_back(p);
-    }
+    const uint8_t flags = (laserstate == LaserState::ON) ? 1 : 0;
+    const int count = basesteps + 1;
+    PrepareBatch(count);
+    PointKernel::StepT(0, count, steps, m_BatchT.data());
+    PointKernel::Arc(center, radiusVecPrev, sweepangle, steps, count, m_BatchX.data(), m_BatchY.data());
+    EmitBatch(count, color, flags);
+    Point2D end = radiusVecPrev.Rotate(sweepangle) + center;
     if (pointsharpness == PointSharpness::SHARP)
     {
-        float rampdownsteps = float(steps - 1);
-        float baseT = rampdownsteps / float(steps);
-        const int brakingPoints = 6;
+        const int brakingPoints = m_BrakingPoints;
+        BrakingT(steps, brakingPoints);
         for (int i = 0; i <= brakingPoints; i++)
         {
-            float t = float(i) / float(brakingPoints);
-            float easedT = baseT + (1.0f - baseT) * GalvoEaseOut(t);
-            Point2D ipoint = radiusVecPrev.Rotate(sweepangle * easedT) + center;
-            //Point2D ipoint = LerpTo(next, easedT);
-            DistortionCorrection(ipoint);
-            ipoint *= m_MaxValue;
-            ClampPoint2D(ipoint);
-            LaserPoint p {};
-            p.x = (int16_t)ipoint.x;
-            p.y = (int16_t)ipoint.y;
-            LaserColor::RGB8 colors = color.getRGB(easedT);
-            p.r = colors.r;
-            p.g = colors.g;
-            p.b = colors.b;
-            p.flags = (laserstate == LaserState::ON) ? true : false;
-            m_Frame.push_back(p);
-        }
-        const int dwellPoints = 4;
-        Point2D ipoint = radiusVecPrev.Rotate(sweepangle) + center;
-        DistortionCorrection(ipoint);
-        ipoint *= m_MaxValue;
-        ClampPoint2D(ipoint);
-        for (int i = 0; i < dwellPoints; i++)
-        {
-            LaserPoint p {};
-            p.x = (int16_t)ipoint.x;
-            p.y = (int16_t)ipoint.y;
-            LaserColor::RGB8 colors = color.getRGB(1.0);
-            p.r = colors.r;
-            p.g = colors.g;
-            p.b = 255;
-            p.flags = (laserstate == LaserState::ON) ? true : false;
-            m_Frame.push_back(p);
+            Point2D ipoint = radiusVecPrev.Rotate(sweepangle * m_BatchT[i]) + center;
+            m_BatchX[i] = ipoint.x;
+            m_BatchY[i] = ipoint.y;
         }
+        EmitBatch(brakingPoints + 1, color, flags);
+        EmitDwell(end, m_DwellPoints, color, flags);
     }
-    m_prev = radiusVecPrev.Rotate(sweepangle) + center;
+    m_prev = end;
 }
 
 void LaserFrameGenerator::DrawShape(const std::vector<Point2D>& points, float t, LaserColor color)
 {
-    int numpoints = static_cast<int>(t * float(points.size()));
-    numpoints = std::clamp(numpoints, 0, int(points.size()));
+    m_DrawCalls.shapes++;
+    const Point2D last = points.at(points.size()-1);
+    if (Recording())
+    {
+        int numpoints = std::clamp(static_cast<int>(t * float(points.size())), 0, int(points.size()));
+        m_Commands.push_back(Command { Command::Type::SHAPE, Point2D(), Point2D(), LaserState::ON, PointSharpness::SMOOTH, Arc::CLOCKWISE, color, float(numpoints), m_ShapePoints.size(), int(points.size()), t });
+        m_ShapePoints.insert(m_ShapePoints.end(), points.begin(), points.end());
+        m_prev = last;
+        return;
+    }
+    DrawPoints(points.data(), int(points.size()), t, color);
+}
+
+void LaserFrameGenerator::DrawPoints(const Point2D* points, int size, float t, LaserColor color)
+{
+    int numpoints = static_cast<int>(t * float(size));
+    numpoints = std::clamp(numpoints, 0, size);
+    // Sized for the whole shape, so a trace drawn a little further every frame does not regrow the scratch
+    PrepareBatch(size);
+    PointKernel::StepT(0, numpoints, size, m_BatchT.data());
     for (int i = 0; i < numpoints; i++)
     {
-        float it = float(i) / float(points.size());
-        Point2D ipoint = points.at(i);
-        DistortionCorrection(ipoint);
-        ipoint *= m_MaxValue;
-        ClampPoint2D(ipoint);
-        LaserPoint p {};
-        p.x = (int16_t)ipoint.x;
-        p.y = (int16_t)ipoint.y;
-        // Color interpolation
-        LaserColor::RGB8 colors = color.getRGB(it);
-        p.r = colors.r;
-        p.g = colors.g;
-        p.b = colors.b;
-        p.flags = true;
-        m_Frame.push_back(p);
-    }
-    m_prev = points.at(points.size()-1);
-}
\ No newline at end of file
+        m_BatchX[i] = points[i].x;
+        m_BatchY[i] = points[i].y;
+    }
+    EmitBatch(numpoints, color, 1);
+    m_prev = points[size - 1];
+}
+
+void LaserFrameGenerator::BeginTemplate(ShapeTemplate& shape, Point2D start, float scale, const LaserColor& shapeColor)
+{
+    shape = ShapeTemplate {};
+    shape.start = start;
+    shape.spacing = m_PointSpacing;
+    shape.brakingPoints = m_BrakingPoints;
+    shape.dwellPoints = m_DwellPoints;
+    m_Capture = &shape;
+    m_CaptureColor = shapeColor;
+    m_CaptureSavedPrev = m_prev;
+    m_CaptureSavedSpacing = m_PointSpacing;
+    // Drawing at scale with spacing s gives the same steps as drawing at 1 with s / scale
+    m_PointSpacing /= scale;
+    m_prev = start;
+}
+
+void LaserFrameGenerator::EndTemplate()
+{
+    m_Capture->end = m_prev;
+    m_Capture = nullptr;
+    m_prev = m_CaptureSavedPrev;
+    m_PointSpacing = m_CaptureSavedSpacing;
+}
+
+bool LaserFrameGenerator::IsTemplateCurrent(const ShapeTemplate& shape) const
+{
+    return shape.spacing == m_PointSpacing && shape.brakingPoints == m_BrakingPoints && shape.dwellPoints == m_DwellPoints;
+}
+
+void LaserFrameGenerator::DrawTemplate(const ShapeTemplate& shape, const Mat3& matrix, const LaserColor& color)
+{
+    m_DrawCalls.templates++;
+    // One pass transforms every stored point into the scratch arrays, then each run is emitted from its slice
+    const int size = int(shape.x.size());
+    PrepareBatch(size);
+    const float m00 = matrix.m[0][0], m01 = matrix.m[0][1], m02 = matrix.m[0][2];
+    const float m10 = matrix.m[1][0], m11 = matrix.m[1][1], m12 = matrix.m[1][2];
+    for (int i = 0; i < size; i++)
+    {
+        float x = shape.x[i];
+        float y = shape.y[i];
+        m_BatchX[i] = x * m00 + y * m01 + m02;
+        m_BatchY[i] = x * m10 + y * m11 + m12;
+    }
+    std::copy(shape.t.begin(), shape.t.end(), m_BatchT.begin());
+    // Slices are consumed in order, so EmitDwell reusing slot 0 only touches spent points
+    for (const ShapeTemplate::Run& run : shape.runs)
+    {
+        const LaserColor& runColor = run.shapeColor ? color : run.color;
+        if (run.dwell)
+            EmitDwell(Point2D(m_BatchX[run.first], m_BatchY[run.first]), run.count, runColor, run.flags);
+        else
+            EmitBatch(run.count, runColor, run.flags, run.first);
+    }
+    m_prev = matrix.transformPoint(shape.end);
+}
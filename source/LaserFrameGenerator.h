@@ -1,8 +1,13 @@
 #pragma once
+#include <array>
 #include <vector>
 #include <cstdint>
+#include <memory_resource>
 #include "LaserColor.h"
+#include "Matrix3X3.h"
 #include "Point2D.h"
+#include "DistortionCorrector.h"
+#include "FrameBuffer.h"
 
 struct LaserPoint
 {
@@ -11,7 +16,33 @@ struct LaserPoint
     uint8_t r, g, b;
     uint8_t flags; // 1 = laser on, 0 = blank
 };
-using LaserFrame = std::vector<LaserPoint>;
+using LaserFrame = std::pmr::vector<LaserPoint>;
+
+// A run of segments tessellated once in local space (see
+// LaserFrameGenerator::BeginTemplate) and replayed under a transform
+struct ShapeTemplate
+{
+    struct Run
+    {
+        int first;       // into x, y, t
+        int count;       // points emitted; a dwell run holds one point emitted count times
+        uint8_t flags;
+        bool dwell;
+        bool shapeColor; // drawn in the color given to DrawTemplate rather than color
+        LaserColor color;
+    };
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> t;
+    std::vector<Run> runs;
+    Point2D start;
+    Point2D end;
+    int points = 0;
+    // Generator settings at capture; the template is stale once they change
+    float spacing = 0.0f;
+    int brakingPoints = 0;
+    int dwellPoints = 0;
+};
 
 class LaserFrameGenerator
 {
@@ -31,22 +62,136 @@ public:
         COUNTERCLOCKWISE,
         CLOCKWISE
     };
+    // Per-frame result of the point budget
+    struct BudgetStats
+    {
+        int budget = 0;          // points the scanner draws in one frame
+        int requestedPoints = 0; // points at the nominal spacing and dwell
+        int emittedPoints = 0;
+        float spacing = 0.0f;    // spacing the frame was drawn with
+        int brakingPoints = 0;
+        int dwellPoints = 0;
+        bool OverBudget() const { return emittedPoints > budget; }
+        int Slack() const { return budget - emittedPoints; } // negative when over budget
+    };
+    // Draw calls since NewFrame; budget replays are not counted again
+    struct DrawCalls
+    {
+        int lines = 0;
+        int arcs = 0;
+        int shapes = 0;
+        int templates = 0;
+    };
     LaserFrameGenerator(float maxextent, float maxAngle);
     ~LaserFrameGenerator() {}
-    void NewFrame() { m_Frame.clear(); }
+    void NewFrame();
+    // Budget mode: emits the recorded frame with spacing and dwell fitted to the budget.
+    // Without a budget the segments are already in the frame and this does nothing.
+    void EndFrame();
     const LaserFrame& GetLaserFrame() { return m_Frame; }
-    void SetAveragePointSpacing(float spacing) { m_averagePointSpacing = spacing; }
+    FrameBufferPolicy& GetFramePolicy() { return m_FramePolicy; }
+    // Moves the frame buffer onto the given resource (e.g. a FrameArena); nullptr returns to the heap
+    void SetFrameMemory(std::pmr::memory_resource* resource);
+    void SetAveragePointSpacing(float spacing) { m_averagePointSpacing = spacing; m_PointSpacing = spacing; }
+    // Caps every frame at pointsPerSecond / framesPerSecond points. Segments are then
+    // recorded and only emitted by EndFrame(), which widens the spacing (up to
+    // maxSpacingScale times the average) and then shortens braking and dwell until the frame fits.
+    void SetPointBudget(float pointsPerSecond, float framesPerSecond, float maxSpacingScale = 4.0f);
+    void ClearPointBudget() { m_PointBudget = 0; }
+    const BudgetStats& GetBudgetStats() const { return m_BudgetStats; }
+    const DrawCalls& GetDrawCalls() const { return m_DrawCalls; }
+    void SetCorrectionMode(DistortionCorrector::Mode mode) { m_Corrector.SetMode(mode); }
+    DistortionCorrector::ErrorReport GetCorrectionErrorReport() const;
+    // Colors points from baked LaserColorTables (default) or with the exact HSV conversion
+    void SetColorTables(bool enabled) { m_UseColorTables = enabled; }
     void LineTo(Point2D next, LaserState laserstate, PointSharpness pointsharpness, LaserColor color);
     void ArcTo(Point2D center, Point2D next, LaserState laserstate, PointSharpness pointsharpness, LaserColor color, Arc direction);
     void DrawShape(const std::vector<Point2D>& points, float t, LaserColor color);
+    // Where the last segment ended (normalized coordinates)
+    Point2D GetPosition() const { return m_prev; }
+    // Points LineTo emits for a segment of this length at the current spacing
+    int CountLinePoints(float length, PointSharpness pointsharpness) const;
+    // Template capture: segments drawn from start until EndTemplate() are tessellated
+    // as if drawn scale times larger and stored in shape instead of the frame.
+    // Segments drawn in shapeColor are replayed in DrawTemplate's color.
+    void BeginTemplate(ShapeTemplate& shape, Point2D start, float scale, const LaserColor& shapeColor);
+    void EndTemplate();
+    bool IsTemplateCurrent(const ShapeTemplate& shape) const;
+    // Budget mode must see every segment, so templates only apply outside it
+    bool CanDrawTemplates() const { return !Recording() && !m_Capture; }
+    // Emits the template's points through matrix, which should scale by the capture scale
+    void DrawTemplate(const ShapeTemplate& shape, const Mat3& matrix, const LaserColor& color);
 private:
+    // A segment recorded in budget mode, replayed by EndFrame()
+    struct Command
+    {
+        enum class Type { LINE, ARC, SHAPE } type;
+        Point2D next;
+        Point2D center;
+        LaserState state;
+        PointSharpness sharpness;
+        Arc direction;
+        LaserColor color;
+        float length;      // path length; SHAPE: points drawn
+        size_t shapeFirst; // SHAPE: range in m_ShapePoints
+        int shapeSize;
+        float t;
+    };
 	void DistortionCorrection(Point2D& p) const;
     float ConvertAngle(const float angle) const;
-    Point2D LerpTo(Point2D next, float t) const;
-    void ClampPoint2D(Point2D& p);
+    // Batched emission through PointKernel, using the m_Batch scratch arrays
+    void PrepareBatch(int count);
+    void EmitBatch(int count, const LaserColor& color, uint8_t flags, int first = 0);
+    void EmitDwell(Point2D p, int count, const LaserColor& color, uint8_t flags);
+    void BrakingT(int steps, int brakingPoints);
+    // The baked table for a run of count points, or nullptr to convert the run exactly
+    const LaserColorTable* ColorTable(const LaserColor& color, int count);
+    float ArcSweep(Point2D center, Point2D next, Arc direction) const;
+    void DrawPoints(const Point2D* points, int size, float t, LaserColor color);
+    bool Recording() const { return m_PointBudget > 0 && !m_Replaying; }
+    // First pass: points the recorded frame takes with these settings
+    int CountRecordedPoints(float spacing, int brakingPoints, int dwellPoints) const;
     LaserFrame m_Frame;
+    FrameBufferPolicy m_FramePolicy;
     Point2D m_prev;
     float m_MaxAngle;
     float m_MaxValue;
     float m_averagePointSpacing;
+    float m_PointSpacing;
+    int m_BrakingPoints = 6;
+    int m_DwellPoints = 4;
+    DistortionCorrector m_Corrector;
+    std::vector<float> m_BatchX;
+    std::vector<float> m_BatchY;
+    std::vector<float> m_BatchT;
+    // Recently used colors, least recently used replaced first. A gradient is baked only
+    // once it has drawn a table's worth of points, so colors seen in short runs, such as
+    // per-entity colors, never cost more than converting them exactly.
+    static constexpr int ColorCacheSize = 32;
+    struct ColorCacheEntry
+    {
+        LaserColor color;
+        int exactPoints = 0; // drawn before the bake
+        bool baked = false;
+        uint64_t lastUse = 0;
+    };
+    std::array<ColorCacheEntry, ColorCacheSize> m_ColorCache;
+    std::vector<LaserColorTable> m_ColorTables = std::vector<LaserColorTable>(ColorCacheSize); // ~3 KB each, kept off the stack
+    int m_ColorTablesUsed = 0;
+    int m_LastColorTable = 0;
+    uint64_t m_ColorUses = 0;
+    bool m_UseColorTables = true;
+    int m_PointBudget = 0;
+    float m_MaxSpacingScale = 4.0f;
+    bool m_Replaying = false;
+    Point2D m_FrameStart;
+    size_t m_FrameStartSize = 0;
+    std::vector<Command> m_Commands;
+    std::vector<Point2D> m_ShapePoints;
+    BudgetStats m_BudgetStats;
+    DrawCalls m_DrawCalls;
+    ShapeTemplate* m_Capture = nullptr;
+    LaserColor m_CaptureColor;
+    Point2D m_CaptureSavedPrev;
+    float m_CaptureSavedSpacing = 0.0f;
 };
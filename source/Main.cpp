@@ -5,20 +5,24 @@
 #include <windowsx.h>
 #include <sal.h>
 #include <chrono>
+#include <cwchar>
+#include <vector>
 #include "GalvoSimulator.h"
 #include "LaserFrameGenerator.h"
 #include "FrameRenderer.h"
 #include "LaserColor.h"
 #include "Shapes.h"
+#include "PathOptimizer.h"
 #include "Point2D.h"
 #include "Matrix3X3.h"
 #include "InputManager.h"
 #include "Object.h"
 #include "Context.h"
+#include "FramePipeline.h"
+#include "FixedStepClock.h"
+#include "Profiler.h"
 #pragma comment(lib, "Comctl32.lib")
 
-using Clock = std::chrono::high_resolution_clock;
-
 static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     switch (msg)
@@ -63,9 +67,12 @@ int WINAPI wWinMain(
 
 	float maxAngle = 35.0f;
 	LaserFrameGenerator frameGenerator(0.9f, maxAngle);
+    frameGenerator.SetCorrectionMode(DistortionCorrector::Mode::LUT);
     GalvoSimulator galvoSimulator(maxAngle);
 	FrameRenderer frameRenderer(hwnd);
     ShapeGenerator  shapeGenerator(frameGenerator);
+    PathOptimizer pathOptimizer(frameGenerator);
+    shapeGenerator.SetPathOptimizer(&pathOptimizer);
     
     // Input
     InputManager input;
@@ -100,16 +107,31 @@ int WINAPI wWinMain(
 	float fps = 60.0f;
     float simsteps = simsteps_per_second / fps;
     float dt = 1.0f / simsteps;
+    // Keep each frame within what the scanner draws at this rate
+    frameGenerator.SetPointBudget(simsteps_per_second, fps);
+    // --profile: record per-stage timings, show them as an overlay and write profile.csv/profile.json on exit
+    const bool profiling = lpCmdLine && wcsstr(lpCmdLine, L"--profile");
+    Profiler& profiler = Profiler::Get();
+    profiler.Enable(profiling);
+    Profiler::FrameCounters counters;
+    std::vector<Profiler::StageTime> stages;
+    std::vector<float> overlay;
+    // Galvo simulation runs on its own thread; Direct2D drawing stays on this one
+    FramePipeline pipeline(galvoSimulator, dt, 2,
+        [&frameRenderer, &counters] (const LaserFrame&, const SimFrame& simFrame)
+        {
+            counters.simSteps = simFrame.size();
+            frameRenderer.DrawFrame(simFrame);
+        }, false);
+    // Game physics advances in fixed 120 Hz steps; the loop itself is capped at fps
+    FixedStepClock frameClock(1.0 / 120.0);
+    frameClock.SetFrameCap(fps);
 	bool running = true;
-    auto lastTime = Clock::now();
     while (running)
     {
-        // Measure current time
-        auto currentTime = Clock::now();
-        std::chrono::duration<float> elapsed = currentTime - lastTime;
-        float deltaT = elapsed.count(); // seconds since last frame
-		context.SetDeltaTime(deltaT);
-        lastTime = currentTime;
+        int steps = frameClock.BeginFrame();
+        profiler.BeginFrame();
+		context.SetDeltaTime(frameClock.GetStepSeconds());
 
 		// INPUT
         input.BeginFrame();
@@ -136,19 +158,40 @@ int WINAPI wWinMain(
         if (!running) break;
 
         // UPDATE
-        context.UpdatePools();
+        for (int step = 0; step < steps; step++)
+            context.UpdatePools();
+        context.SetInterpolation(frameClock.Alpha());
 
         // Drawing
+        pipeline.BeginFrame();
         frameGenerator.NewFrame();
         context.DrawPools();
-        // Simulate galvo physics
-        galvoSimulator.Simulate(frameGenerator.GetLaserFrame(), dt); 
+        frameGenerator.EndFrame();
+        // Simulate galvo physics on the pipeline thread
+        pipeline.Submit(frameGenerator.GetLaserFrame());
 
-		// Render
-		frameRenderer.DrawFrame(galvoSimulator.GetSimFrame());
+		// Render whatever the simulator has finished
+		pipeline.Poll();
         input.EndFrame();
-        Sleep(1);
+        if (profiling)
+        {
+            counters.CountLit(frameGenerator.GetLaserFrame());
+            counters.CountDraws(frameGenerator.GetDrawCalls());
+            profiler.EndFrame(counters);
+            profiler.GetLastFrameStages(stages);
+            overlay.clear();
+            for (const Profiler::StageTime& stage : stages)
+                overlay.push_back(float(stage.ms));
+            frameRenderer.SetTimingOverlay(overlay, 1000.0f / fps);
+        }
+        frameClock.WaitForNextFrame();
     }
 
+    if (profiling)
+    {
+        pipeline.Flush();
+        profiler.WriteCsv("profile.csv");
+        profiler.WriteChromeTrace("profile.json");
+    }
     return 0;
 }
@@ -1,5 +1,4 @@
 #include "Object.h"
-#include "InputManager.h"
 #include "LaserFrameGenerator.h"
 #include "LaserColor.h"
 #include "Shapes.h" 
@@ -15,7 +14,10 @@ void Ship::Update(GameContext& context)
 }
 void Ship::Draw(GameContext& context)
 {
-    Mat3 matrix = Mat3::Translation(m_Pos.x, m_Pos.y) * Mat3::Rotation(m_Angle) * Mat3::Scale(1.0f, 1.0f);
+    // Motion is linear within a step, so stepping back along it interpolates
+    float lag = context.GetDrawLag();
+    Point2D pos = m_Pos - m_Vel * lag;
+    Mat3 matrix = Mat3::Translation(pos.x, pos.y) * Mat3::Rotation(m_Angle - m_AngVel * lag) * Mat3::Scale(1.0f, 1.0f);
     context.m_shapeGen.Ship(matrix, m_color);
 }
 
@@ -39,12 +41,12 @@ void Ship::BindControls(GameContext& context)
 
 void BulletPool::DrawAll(GameContext& context)
 {
+    float lag = context.GetDrawLag();
     for (int i = 0; i < activeCount; i++)
     {
-        Bullet& b = bullets[i];
         ShapeGenerator& shapeGen = context.m_shapeGen;
-        Mat3 matrix = Mat3::Translation(b.m_Pos.x, b.m_Pos.y) * Mat3::Rotation(b.m_Angle) * Mat3::Scale(0.01f, 0.01f);
-        shapeGen.Square(matrix, b.m_color);
+        Mat3 matrix = Mat3::Translation(posX[i] - velX[i] * lag, posY[i] - velY[i] * lag) * Mat3::Rotation(angle[i] - angVel[i] * lag) * Mat3::Scale(0.01f, 0.01f);
+        shapeGen.Square(matrix, data[i].m_color);
     }
 }
 
@@ -4,9 +4,10 @@
 #include <memory>
 #include "Point2D.h"
 #include "LaserColor.h"
-#include "Matrix3x3.h"
+#include "Matrix3X3.h"
 #include "EventManager.h"
 #include "Shapes.h"
+#include "EntityPool.h"
 
 class LaserFrameGenerator;
 class InputManager;
@@ -87,47 +88,31 @@ struct Bullet
     float m_Lifetime = 0.0f;  // seconds remaining
 };
 
-class BulletPool
+struct BulletData
+{
+    Mat3 m_ObjectMatrix;
+    LaserColor m_color;
+};
+
+// Bullets are stored structure-of-arrays; Bullet is only the spawn record
+class BulletPool : public EntityPool<BulletData>
 {
 public:
-    BulletPool() {}
     static constexpr int MaxBullets = 256;
-    //Bullet bullets[MaxBullets];
-    std::unique_ptr<Bullet[]> bullets = std::make_unique<Bullet[]>(MaxBullets);
-    int activeCount = 0;
+    BulletPool() : EntityPool(MaxBullets) {}
 
     void Spawn(const Bullet& b)
     {
-        if (activeCount >= MaxBullets) return;
-        bullets[activeCount++] = b;
-    }
-
-    void Deactivate(int index)
-    {
-        if (index < 0 || index >= activeCount) return;
-        bullets[index] = bullets[activeCount - 1];
-        activeCount--;
+        EntityPool::Spawn(b.m_Pos, b.m_Vel, b.m_Angle, b.m_AngVel, b.m_Lifetime, BulletData { b.m_ObjectMatrix, b.m_color });
     }
 
     void UpdateAll(float dt)
     {
-        for (int i = 0; i < activeCount; )
-        {
-            Bullet& b = bullets[i];
-			b.m_Pos += b.m_Vel * dt;
-			b.m_Angle += b.m_AngVel * dt;
-            b.m_Lifetime -= dt;
-
-            if (b.m_Lifetime <= 0)
-            {
-                Deactivate(i); // swaps last active in
-            }
-            else
-            {
-                ++i; // only increment if we didnt remove the bullet
-            }
-        }
+        Integrate(dt);
+        Age(dt);
+        RemoveDead();
     }
+    void RemoveDead() { RemoveIf([this] (int i) { return lifetime[i] <= 0; }); }
     void DrawAll(GameContext& context);
 };
 
@@ -149,47 +134,44 @@ struct Asteroid
     float m_AngVel = 0.0f; // angular velocity
     int m_HitPoints = 0;  // seconds remaining
 	AsteroidSize m_Size = AsteroidSize::SMALL;
+    // Collision radius in normalized units
+    static float Radius(AsteroidSize size)
+    {
+        switch (size)
+        {
+        case AsteroidSize::LARGE: return 0.12f;
+        case AsteroidSize::MEDIUM: return 0.06f;
+        case AsteroidSize::SMALL: default: return 0.03f;
+        }
+    }
 };
 
-class AsteroidPool
+struct AsteroidData
+{
+    Mat3 m_ObjectMatrix;
+    LaserColor m_color;
+    int m_HitPoints = 0;
+    Asteroid::AsteroidSize m_Size = Asteroid::AsteroidSize::SMALL;
+};
+
+// Asteroids are stored structure-of-arrays; Asteroid is only the spawn record
+class AsteroidPool : public EntityPool<AsteroidData>
 {
 public:
     static constexpr int MaxAsteroids = 256;
-    //Asteroid asteroids[MaxAsteroids];
-    std::unique_ptr<Asteroid[]> asteroids = std::make_unique<Asteroid[]>(MaxAsteroids);
-    int activeCount = 0;
+    AsteroidPool() : EntityPool(MaxAsteroids) {}
 
     void Spawn(const Asteroid& a)
     {
-        if (activeCount >= MaxAsteroids) return;
-        asteroids[activeCount++] = a;
-    }
-
-    void Deactivate(int index)
-    {
-        if (index < 0 || index >= activeCount) return;
-        asteroids[index] = asteroids[activeCount - 1];
-        activeCount--;
+        EntityPool::Spawn(a.m_Pos, a.m_Vel, a.m_Angle, a.m_AngVel, 0.0f, AsteroidData { a.m_ObjectMatrix, a.m_color, a.m_HitPoints, a.m_Size });
     }
 
     void UpdateAll(float dt)
     {
-        for (int i = 0; i < activeCount; )
-        {
-            Asteroid& a = asteroids[i];
-            a.m_Pos += a.m_Vel * dt;
-            a.m_Angle += a.m_AngVel * dt;
-
-            if (a.m_HitPoints <= 0)
-            {
-                Deactivate(i); // swaps last active in
-            }
-            else
-            {
-                ++i; // only increment if we didnt remove the bullet
-            }
-        }
+        Integrate(dt);
+        RemoveDead();
     }
+    void RemoveDead() { RemoveIf([this] (int i) { return data[i].m_HitPoints <= 0; }); }
 };
 
 
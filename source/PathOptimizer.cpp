@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "PathOptimizer.h"
+#include "LaserColor.h"
+#include "LaserFrameGenerator.h"
+#include "Point2D.h"
+#include "Profiler.h"
+
+using LS = LaserFrameGenerator::LaserState;
+using PS = LaserFrameGenerator::PointSharpness;
+using ARC = LaserFrameGenerator::Arc;
+
+static float Distance(Point2D a, Point2D b)
+{
+    return (b - a).Length();
+}
+
+void PathOptimizer::LineTo(Point2D next, LS laserstate, PS pointsharpness, LaserColor color)
+{
+    if (laserstate == LS::OFF)
+    {
+        // A blank move ends the current stroke and positions the next one
+        FinishStroke();
+        m_Pending = Stroke { next, 0, 0, pointsharpness, color, false, false, true };
+        m_Position = next;
+        m_HavePosition = true;
+        return;
+    }
+    if (!m_StrokeOpen)
+    {
+        if (!m_Pending.hasBlank)
+            m_Pending.start = m_HavePosition ? m_Position : m_LaserGen.GetPosition();
+        m_Pending.firstSegment = m_Segments.size();
+        m_StrokeOpen = true;
+    }
+    m_Segments.push_back(Segment { false, next, Point2D(), pointsharpness, ARC::CLOCKWISE, color });
+    m_Position = next;
+    m_HavePosition = true;
+}
+
+void PathOptimizer::ArcTo(Point2D center, Point2D next, LS laserstate, PS pointsharpness, LaserColor color, ARC direction)
+{
+    if (laserstate == LS::OFF)
+    {
+        // Blank arcs become straight blank moves
+        LineTo(next, laserstate, pointsharpness, color);
+        return;
+    }
+    LineTo(next, laserstate, pointsharpness, color);
+    Segment& segment = m_Segments.back();
+    segment.arc = true;
+    segment.center = center;
+    segment.direction = direction;
+}
+
+void PathOptimizer::FinishStroke()
+{
+    if (!m_StrokeOpen)
+        return;
+    m_StrokeOpen = false;
+    Stroke stroke = m_Pending;
+    stroke.segmentCount = m_Segments.size() - stroke.firstSegment;
+    const Segment* segments = &m_Segments[stroke.firstSegment];
+    stroke.closed = Distance(segments[stroke.segmentCount - 1].end, stroke.start) < 1e-5f;
+    stroke.reversible = true;
+    for (size_t i = 1; i < stroke.segmentCount; i++)
+    {
+        // Dwell sits at segment ends, so mixed sharpness would move when drawn backwards
+        if (segments[i].sharpness != segments[0].sharpness)
+            stroke.reversible = false;
+    }
+    m_Strokes.push_back(stroke);
+    m_Pending = Stroke {};
+}
+
+Point2D PathOptimizer::Vertex(const Stroke& stroke, size_t index) const
+{
+    return index == 0 ? stroke.start : m_Segments[stroke.firstSegment + index - 1].end;
+}
+
+Point2D PathOptimizer::Entry(const Visit& visit) const
+{
+    return Vertex(m_Strokes[visit.stroke], visit.entryVertex);
+}
+
+// A rotated loop ends with the segment into its start vertex, so that segment must
+// carry the braking a SHARP end gets; uniform loops look the same from any vertex
+bool PathOptimizer::CanStartAt(const Stroke& stroke, size_t vertex) const
+{
+    if (vertex == 0 || stroke.reversible)
+        return true;
+    return m_Segments[stroke.firstSegment + vertex - 1].sharpness == PS::SHARP;
+}
+
+Point2D PathOptimizer::Exit(const Visit& visit) const
+{
+    const Stroke& stroke = m_Strokes[visit.stroke];
+    if (stroke.closed)
+        return Vertex(stroke, visit.entryVertex);
+    return Vertex(stroke, visit.reversed ? 0 : stroke.segmentCount);
+}
+
+float PathOptimizer::BlankDistance(Point2D origin, const std::vector<Visit>& plan, int& points) const
+{
+    float distance = 0.0f;
+    points = 0;
+    Point2D position = origin;
+    for (const Visit& visit : plan)
+    {
+        const Stroke& stroke = m_Strokes[visit.stroke];
+        Point2D entry = Entry(visit);
+        float d = Distance(position, entry);
+        distance += d;
+        if (stroke.hasBlank || d > 0.0f)
+            points += m_LaserGen.CountLinePoints(d, stroke.blankSharpness);
+        position = Exit(visit);
+    }
+    return distance;
+}
+
+void PathOptimizer::PlanNearestNeighbour(Point2D origin)
+{
+    m_Plan.clear();
+    m_Used.assign(m_Strokes.size(), 0);
+    Point2D position = origin;
+    for (size_t n = 0; n < m_Strokes.size(); n++)
+    {
+        Visit best { -1, 0, false };
+        float bestDistance = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < m_Strokes.size(); i++)
+        {
+            if (m_Used[i])
+                continue;
+            const Stroke& stroke = m_Strokes[i];
+            auto consider = [&] (int vertex, bool reversed)
+            {
+                float d = Distance(position, Vertex(stroke, vertex));
+                if (d < bestDistance)
+                {
+                    bestDistance = d;
+                    best = Visit { int(i), vertex, reversed };
+                }
+            };
+            if (stroke.closed)
+            {
+                int vertices = m_AllowRotate ? int(stroke.segmentCount) : 1;
+                for (int k = 0; k < vertices; k++)
+                {
+                    if (CanStartAt(stroke, size_t(k)))
+                        consider(k, false);
+                }
+            }
+            else
+            {
+                consider(0, false);
+                if (m_AllowReverse && stroke.reversible)
+                    consider(int(stroke.segmentCount), true);
+            }
+        }
+        m_Used[best.stroke] = 1;
+        m_Plan.push_back(best);
+        position = Exit(best);
+    }
+}
+
+void PathOptimizer::ImproveTwoOpt(Point2D origin)
+{
+    // Reversing plan[i..j] draws that run backwards: open strokes flip direction,
+    // closed loops enter and leave at the same vertex so they are unaffected
+    const int count = int(m_Plan.size());
+    auto flippable = [&] (const Visit& visit)
+    {
+        const Stroke& stroke = m_Strokes[visit.stroke];
+        return stroke.closed || (m_AllowReverse && stroke.reversible);
+    };
+    for (int pass = 0; pass < m_TwoOptPasses; pass++)
+    {
+        bool improved = false;
+        for (int i = 0; i < count; i++)
+        {
+            if (!flippable(m_Plan[i]))
+                continue;
+            Point2D before = (i == 0) ? origin : Exit(m_Plan[i - 1]);
+            Point2D first = Entry(m_Plan[i]);
+            for (int j = i; j < count; j++)
+            {
+                if (!flippable(m_Plan[j]))
+                    break;
+                Point2D last = Exit(m_Plan[j]);
+                float removed = Distance(before, first);
+                float added = Distance(before, last);
+                if (j + 1 < count)
+                {
+                    Point2D after = Entry(m_Plan[j + 1]);
+                    removed += Distance(last, after);
+                    added += Distance(first, after);
+                }
+                if (added + 1e-6f < removed)
+                {
+                    std::reverse(m_Plan.begin() + i, m_Plan.begin() + j + 1);
+                    for (int k = i; k <= j; k++)
+                    {
+                        Visit& visit = m_Plan[k];
+                        const Stroke& stroke = m_Strokes[visit.stroke];
+                        if (stroke.closed)
+                            continue;
+                        visit.reversed = !visit.reversed;
+                        visit.entryVertex = visit.reversed ? int(stroke.segmentCount) : 0;
+                    }
+                    improved = true;
+                    first = Entry(m_Plan[i]);
+                }
+            }
+        }
+        if (!improved)
+            break;
+    }
+}
+
+void PathOptimizer::PickLoopStarts(Point2D origin)
+{
+    if (!m_AllowRotate)
+        return;
+    for (size_t i = 0; i < m_Plan.size(); i++)
+    {
+        Visit& visit = m_Plan[i];
+        const Stroke& stroke = m_Strokes[visit.stroke];
+        if (!stroke.closed)
+            continue;
+        Point2D before = (i == 0) ? origin : Exit(m_Plan[i - 1]);
+        bool hasAfter = i + 1 < m_Plan.size();
+        Point2D after = hasAfter ? Entry(m_Plan[i + 1]) : Point2D();
+        float bestCost = std::numeric_limits<float>::max();
+        for (size_t k = 0; k < stroke.segmentCount; k++)
+        {
+            if (!CanStartAt(stroke, k))
+                continue;
+            Point2D v = Vertex(stroke, k);
+            float cost = Distance(before, v) + (hasAfter ? Distance(v, after) : 0.0f);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                visit.entryVertex = int(k);
+            }
+        }
+    }
+}
+
+void PathOptimizer::Emit(const Visit& visit)
+{
+    const Stroke& stroke = m_Strokes[visit.stroke];
+    Point2D entry = Entry(visit);
+    if (stroke.hasBlank || Distance(m_LaserGen.GetPosition(), entry) > 0.0f)
+        m_LaserGen.LineTo(entry, LS::OFF, stroke.blankSharpness, stroke.blankColor);
+    const size_t n = stroke.segmentCount;
+    for (size_t j = 0; j < n; j++)
+    {
+        if (!visit.reversed)
+        {
+            size_t index = stroke.closed ? (visit.entryVertex + j) % n : j;
+            const Segment& segment = m_Segments[stroke.firstSegment + index];
+            if (segment.arc)
+                m_LaserGen.ArcTo(segment.center, segment.end, LS::ON, segment.sharpness, segment.color, segment.direction);
+            else
+                m_LaserGen.LineTo(segment.end, LS::ON, segment.sharpness, segment.color);
+        }
+        else
+        {
+            size_t index = n - 1 - j;
+            const Segment& segment = m_Segments[stroke.firstSegment + index];
+            Point2D target = Vertex(stroke, index);
+            if (segment.arc)
+            {
+                ARC direction = (segment.direction == ARC::CLOCKWISE) ? ARC::COUNTERCLOCKWISE : ARC::CLOCKWISE;
+                m_LaserGen.ArcTo(segment.center, target, LS::ON, segment.sharpness, segment.color.Reversed(), direction);
+            }
+            else
+            {
+                m_LaserGen.LineTo(target, LS::ON, segment.sharpness, segment.color.Reversed());
+            }
+        }
+    }
+}
+
+void PathOptimizer::Flush()
+{
+    PROFILE_SCOPE("PathOptimizer");
+    // A blank move with no ON segments after it positions no stroke; it is replayed at the end
+    Stroke trailingBlank = m_StrokeOpen ? Stroke {} : m_Pending;
+    FinishStroke();
+    m_Stats = Stats {};
+    m_Stats.strokes = int(m_Strokes.size());
+    const Point2D origin = m_LaserGen.GetPosition();
+
+    m_Plan.clear();
+    for (size_t i = 0; i < m_Strokes.size(); i++)
+        m_Plan.push_back(Visit { int(i), 0, false });
+    m_Stats.blankDistanceBefore = BlankDistance(origin, m_Plan, m_Stats.blankPointsBefore);
+    m_Recorded = m_Plan;
+
+    PlanNearestNeighbour(origin);
+    ImproveTwoOpt(origin);
+    PickLoopStarts(origin);
+    m_Stats.blankDistanceAfter = BlankDistance(origin, m_Plan, m_Stats.blankPointsAfter);
+    if (m_Stats.blankDistanceAfter > m_Stats.blankDistanceBefore)
+    {
+        // Greedy can lose on already well-ordered input; keep the original then
+        m_Plan.swap(m_Recorded);
+        m_Stats.blankDistanceAfter = m_Stats.blankDistanceBefore;
+        m_Stats.blankPointsAfter = m_Stats.blankPointsBefore;
+    }
+
+    for (const Visit& visit : m_Plan)
+        Emit(visit);
+    if (trailingBlank.hasBlank)
+        m_LaserGen.LineTo(trailingBlank.start, LS::OFF, trailingBlank.blankSharpness, trailingBlank.blankColor);
+
+    m_Segments.clear();
+    m_Strokes.clear();
+    m_Plan.clear();
+    m_Pending = Stroke {};
+    m_HavePosition = false;
+}
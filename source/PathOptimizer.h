@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "LaserColor.h"
+#include "LaserFrameGenerator.h"
+#include "Point2D.h"
+
+// Collects a frame's drawing as strokes and emits them in an order that
+// minimizes blank (laser off) travel.
+// Every OFF move ends a stroke; the ON segments that follow form the next one.
+// On Flush() the strokes are ordered by nearest neighbour from the generator's
+// current position and refined with 2-opt. Open strokes may be drawn backwards
+// and closed loops may start at another vertex, as long as that keeps the
+// braking and dwell of their SHARP corners: a loop only starts at a vertex
+// that follows a SHARP segment, unless all its segments share one sharpness.
+// The blank moves are then regenerated between strokes; a blank move that
+// ends the recording is emitted last, so the frame still ends where it did.
+class PathOptimizer
+{
+public:
+    struct Stats
+    {
+        int strokes = 0;
+        float blankDistanceBefore = 0.0f; // recorded order
+        float blankDistanceAfter = 0.0f;  // optimized order
+        int blankPointsBefore = 0;        // points the blank moves cost
+        int blankPointsAfter = 0;
+        int PointsSaved() const { return blankPointsBefore - blankPointsAfter; }
+    };
+    PathOptimizer(LaserFrameGenerator& generator) : m_LaserGen(generator) {}
+    void SetAllowReverse(bool allow) { m_AllowReverse = allow; }
+    void SetAllowRotate(bool allow) { m_AllowRotate = allow; }
+    void SetTwoOptPasses(int passes) { m_TwoOptPasses = passes; }
+    // Same contract as LaserFrameGenerator; the segment is recorded, not emitted
+    void LineTo(Point2D next, LaserFrameGenerator::LaserState laserstate, LaserFrameGenerator::PointSharpness pointsharpness, LaserColor color);
+    void ArcTo(Point2D center, Point2D next, LaserFrameGenerator::LaserState laserstate, LaserFrameGenerator::PointSharpness pointsharpness, LaserColor color, LaserFrameGenerator::Arc direction);
+    // Orders the recorded strokes, emits them into the generator and clears the recording
+    void Flush();
+    const Stats& GetStats() const { return m_Stats; }
+private:
+    struct Segment
+    {
+        bool arc;
+        Point2D end;
+        Point2D center;
+        LaserFrameGenerator::PointSharpness sharpness;
+        LaserFrameGenerator::Arc direction;
+        LaserColor color;
+    };
+    struct Stroke
+    {
+        Point2D start;
+        size_t firstSegment;
+        size_t segmentCount;
+        LaserFrameGenerator::PointSharpness blankSharpness;
+        LaserColor blankColor;
+        bool closed;
+        bool reversible; // every segment has the same sharpness
+        bool hasBlank; // recorded with a leading OFF move
+    };
+    // One stroke in the output order: where the beam enters it and in which direction
+    struct Visit
+    {
+        int stroke;
+        int entryVertex;
+        bool reversed;
+    };
+    Point2D Vertex(const Stroke& stroke, size_t index) const;
+    Point2D Entry(const Visit& visit) const;
+    Point2D Exit(const Visit& visit) const;
+    bool CanStartAt(const Stroke& stroke, size_t vertex) const;
+    void FinishStroke();
+    void PlanNearestNeighbour(Point2D origin);
+    void ImproveTwoOpt(Point2D origin);
+    void PickLoopStarts(Point2D origin);
+    float BlankDistance(Point2D origin, const std::vector<Visit>& plan, int& points) const;
+    void Emit(const Visit& visit);
+
+    LaserFrameGenerator& m_LaserGen;
+    std::vector<Segment> m_Segments;
+    std::vector<Stroke> m_Strokes;
+    std::vector<Visit> m_Plan;
+    std::vector<Visit> m_Recorded;
+    std::vector<char> m_Used;
+    bool m_StrokeOpen = false;
+    bool m_HavePosition = false;
+    Point2D m_Position;
+    Stroke m_Pending {};
+    bool m_AllowReverse = true;
+    bool m_AllowRotate = true;
+    int m_TwoOptPasses = 2;
+    Stats m_Stats;
+};
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "PointKernel.h"
+#include "LaserColor.h"
+#include "LaserFrameGenerator.h"
+#include "Point2D.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POINTKERNEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+void PointKernel::StepT(int first, int count, int steps, float* t)
+{
+    int k = 0;
+    const float fsteps = float(steps);
+#ifdef POINTKERNEL_SSE2
+    // Division rather than a reciprocal multiply keeps t identical to float(i) / float(steps)
+    const __m128 vsteps = _mm_set1_ps(fsteps);
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    for (; k + 4 <= count; k += 4)
+    {
+        __m128i vi = _mm_add_epi32(_mm_set1_epi32(first + k), lane);
+        _mm_storeu_ps(t + k, _mm_div_ps(_mm_cvtepi32_ps(vi), vsteps));
+    }
+#endif
+    for (; k < count; k++)
+    {
+        t[k] = float(first + k) / fsteps;
+    }
+}
+
+void PointKernel::Lerp(Point2D start, Point2D delta, const float* t, int count, float* x, float* y)
+{
+    int k = 0;
+#ifdef POINTKERNEL_SSE2
+    const __m128 sx = _mm_set1_ps(start.x);
+    const __m128 sy = _mm_set1_ps(start.y);
+    const __m128 dx = _mm_set1_ps(delta.x);
+    const __m128 dy = _mm_set1_ps(delta.y);
+    for (; k + 4 <= count; k += 4)
+    {
+        __m128 vt = _mm_loadu_ps(t + k);
+        _mm_storeu_ps(x + k, _mm_add_ps(sx, _mm_mul_ps(dx, vt)));
+        _mm_storeu_ps(y + k, _mm_add_ps(sy, _mm_mul_ps(dy, vt)));
+    }
+#endif
+    for (; k < count; k++)
+    {
+        x[k] = start.x + delta.x * t[k];
+        y[k] = start.y + delta.y * t[k];
+    }
+}
+
+void PointKernel::Arc(Point2D center, Point2D radiusVec, float sweep, int steps, int count, float* x, float* y)
+{
+    const float stepAngle = sweep / float(steps);
+    const float c = std::cos(stepAngle);
+    const float s = std::sin(stepAngle);
+    Point2D v = radiusVec;
+    for (int k = 0; k < count; k++)
+    {
+        if (k > 0 && k % ArcRenormInterval == 0)
+            v = radiusVec.Rotate(sweep * (float(k) / float(steps)));
+        x[k] = center.x + v.x;
+        y[k] = center.y + v.y;
+        v = Point2D(v.x * c - v.y * s, v.x * s + v.y * c);
+    }
+}
+
+void PointKernel::Quantize(const float* x, const float* y, int count, float maxValue, LaserPoint* out)
+{
+    int k = 0;
+#ifdef POINTKERNEL_SSE2
+    const __m128 vmax = _mm_set1_ps(maxValue);
+    const __m128 vmin = _mm_set1_ps(-maxValue);
+    alignas(16) int32_t qx[4];
+    alignas(16) int32_t qy[4];
+    for (; k + 4 <= count; k += 4)
+    {
+        __m128 vx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(x + k), vmax), vmin), vmax);
+        __m128 vy = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(y + k), vmax), vmin), vmax);
+        // cvtt truncates toward zero, same as the (int16_t) cast on an in-range float
+        _mm_store_si128(reinterpret_cast<__m128i*>(qx), _mm_cvttps_epi32(vx));
+        _mm_store_si128(reinterpret_cast<__m128i*>(qy), _mm_cvttps_epi32(vy));
+        for (int l = 0; l < 4; l++)
+        {
+            out[k + l].x = int16_t(qx[l]);
+            out[k + l].y = int16_t(qy[l]);
+        }
+    }
+#endif
+    for (; k < count; k++)
+    {
+        out[k].x = (int16_t)std::clamp(x[k] * maxValue, -maxValue, maxValue);
+        out[k].y = (int16_t)std::clamp(y[k] * maxValue, -maxValue, maxValue);
+    }
+}
+
+void PointKernel::Colorize(const LaserColor& color, const float* t, int count, uint8_t flags, LaserPoint* out)
+{
+    for (int k = 0; k < count; k++)
+    {
+        LaserColor::RGB8 colors = color.getRGB(t[k]);
+        out[k].r = colors.r;
+        out[k].g = colors.g;
+        out[k].b = colors.b;
+        out[k].flags = flags;
+    }
+}
+
+void PointKernel::Colorize(const LaserColorTable& table, const float* t, int count, uint8_t flags, LaserPoint* out)
+{
+    if (table.IsSolid())
+    {
+        LaserColor::RGB8 colors = table.Lookup(0.0f);
+        for (int k = 0; k < count; k++)
+        {
+            out[k].r = colors.r;
+            out[k].g = colors.g;
+            out[k].b = colors.b;
+            out[k].flags = flags;
+        }
+        return;
+    }
+    for (int k = 0; k < count; k++)
+    {
+        LaserColor::RGB8 colors = table.Lookup(t[k]);
+        out[k].r = colors.r;
+        out[k].g = colors.g;
+        out[k].b = colors.b;
+        out[k].flags = flags;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include "LaserColor.h"
+#include "LaserFrameGenerator.h"
+#include "Point2D.h"
+
+// Batched building blocks for LaserFrameGenerator's point emission.
+// Segments are processed as structure-of-arrays scratch (x[], y[], t[]) so
+// the position math runs 4 lanes at a time with SSE2, falling back to plain
+// loops elsewhere. Every lane performs the same float operations, in the same
+// order, as the original per-point code so the output is bit-identical
+// (Arc excepted, see below).
+class PointKernel
+{
+public:
+    // t[k] = (first + k) / steps
+    static void StepT(int first, int count, int steps, float* t);
+    // x[k] = start.x + delta.x * t[k] (and y)
+    static void Lerp(Point2D start, Point2D delta, const float* t, int count, float* x, float* y);
+    // x[k], y[k] = center + radiusVec rotated by sweep * k / steps.
+    // Advances with a fixed rotation matrix (one cos/sin pair per arc) and
+    // re-anchors with an exact rotation every ArcRenormInterval points so
+    // float drift stays bounded on large arcs.
+    static void Arc(Point2D center, Point2D radiusVec, float sweep, int steps, int count, float* x, float* y);
+    static constexpr int ArcRenormInterval = 64;
+    // Scale to DAC units, clamp to +-maxValue and truncate into out[k].x/y
+    static void Quantize(const float* x, const float* y, int count, float maxValue, LaserPoint* out);
+    // Gradient color at t[k] plus the blanking flag
+    static void Colorize(const LaserColor& color, const float* t, int count, uint8_t flags, LaserPoint* out);
+    // Same from a baked table; solid colors fill without reading t
+    static void Colorize(const LaserColorTable& table, const float* t, int count, uint8_t flags, LaserPoint* out);
+};
@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC 1
+#endif
+
+static thread_local void* t_Buffer = nullptr;
+
+static uint64_t SteadyNanoseconds()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Profiler& Profiler::Get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : m_Frames(FrameCapacity) {}
+
+uint64_t Profiler::Now()
+{
+#ifdef PROFILER_RDTSC
+    return __rdtsc();
+#else
+    return SteadyNanoseconds();
+#endif
+}
+
+void Profiler::Calibrate()
+{
+#ifdef PROFILER_RDTSC
+    // Time the TSC against steady_clock once; invariant TSCs tick at a constant rate
+    uint64_t ns0 = SteadyNanoseconds();
+    uint64_t tsc0 = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t ns1 = SteadyNanoseconds();
+    uint64_t tsc1 = __rdtsc();
+    if (tsc1 > tsc0)
+        m_MsPerTick = double(ns1 - ns0) * 1e-6 / double(tsc1 - tsc0);
+#endif
+}
+
+void Profiler::Enable(bool enabled)
+{
+    static std::once_flag calibrated;
+    if (enabled)
+        std::call_once(calibrated, [this] () { Calibrate(); });
+    m_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer& Profiler::LocalBuffer()
+{
+    if (!t_Buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->thread = int(m_Threads.size()) + 1;
+        buffer->events = std::make_unique<Event[]>(EventCapacity);
+        t_Buffer = buffer.get();
+        m_Threads.push_back(std::move(buffer));
+    }
+    return *static_cast<ThreadBuffer*>(t_Buffer);
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+    ThreadBuffer& buffer = LocalBuffer();
+    uint64_t written = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[written & (EventCapacity - 1)] = Event { name, start, end };
+    buffer.written.store(written + 1, std::memory_order_release);
+}
+
+void Profiler::BeginFrame()
+{
+    m_FrameStart = IsEnabled() ? Now() : 0;
+}
+
+void Profiler::EndFrame(const FrameCounters& counters)
+{
+    if (!IsEnabled() || m_FrameStart == 0)
+        return;
+    m_Frames[m_FramesWritten % FrameCapacity] = Frame { m_FrameStart, Now(), counters };
+    m_FramesWritten++;
+}
+
+template <typename Visit>
+void Profiler::ForEachEvent(Visit visit)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : m_Threads)
+    {
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t first = (written > EventCapacity) ? written - EventCapacity : 0;
+        for (uint64_t i = first; i < written; i++)
+            visit(buffer->thread, buffer->events[i & (EventCapacity - 1)]);
+    }
+}
+
+std::vector<const char*> Profiler::StageNames()
+{
+    std::vector<const char*> names;
+    ForEachEvent([&names] (int, const Event& event)
+    {
+        auto same = [&event] (const char* name) { return std::strcmp(name, event.name) == 0; };
+        if (std::find_if(names.begin(), names.end(), same) == names.end())
+            names.push_back(event.name);
+    });
+    return names;
+}
+
+void Profiler::GetLastFrameStages(std::vector<StageTime>& stages)
+{
+    stages.clear();
+    if (m_FramesWritten == 0)
+        return;
+    const Frame& frame = m_Frames[(m_FramesWritten - 1) % FrameCapacity];
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : m_Threads)
+    {
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t first = (written > EventCapacity) ? written - EventCapacity : 0;
+        // Newest first; events land in end order, so stop once they end before the frame
+        for (uint64_t i = written; i-- > first; )
+        {
+            const Event& event = buffer->events[i & (EventCapacity - 1)];
+            if (event.end < frame.start)
+                break;
+            if (event.start >= frame.end)
+                continue;
+            auto same = [&event] (const StageTime& stage) { return std::strcmp(stage.name, event.name) == 0; };
+            auto it = std::find_if(stages.begin(), stages.end(), same);
+            if (it == stages.end())
+                stages.push_back(StageTime { event.name, TicksToMs(event.end - event.start) });
+            else
+                it->ms += TicksToMs(event.end - event.start);
+        }
+    }
+}
+
+bool Profiler::WriteCsv(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    std::vector<const char*> names = StageNames();
+    std::fprintf(file, "frame,start_ms,frame_ms");
+    for (const char* name : names)
+        std::fprintf(file, ",%s_ms", name);
+    std::fprintf(file, ",laser_points,lit_points,blank_points,lit_ratio,sim_steps,line_calls,arc_calls,shape_calls,template_calls\n");
+
+    // Sort events by start so one sweep attributes them to frames
+    struct Entry
+    {
+        uint64_t start;
+        uint64_t duration;
+        size_t stage;
+    };
+    std::vector<Entry> entries;
+    // Once a thread's ring has wrapped, frames before its oldest kept event have lost stage times
+    uint64_t covered = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const std::unique_ptr<ThreadBuffer>& buffer : m_Threads)
+        {
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            if (written > EventCapacity)
+                covered = std::max(covered, buffer->events[written & (EventCapacity - 1)].start);
+        }
+    }
+    ForEachEvent([&] (int, const Event& event)
+    {
+        size_t stage = 0;
+        while (std::strcmp(names[stage], event.name) != 0)
+            stage++;
+        entries.push_back(Entry { event.start, event.end - event.start, stage });
+    });
+    std::sort(entries.begin(), entries.end(), [] (const Entry& a, const Entry& b) { return a.start < b.start; });
+
+    uint64_t firstFrame = (m_FramesWritten > FrameCapacity) ? m_FramesWritten - FrameCapacity : 0;
+    uint64_t origin = (m_FramesWritten > 0) ? m_Frames[firstFrame % FrameCapacity].start : 0;
+    std::vector<double> stageMs(names.size());
+    size_t next = 0;
+    for (uint64_t f = firstFrame; f < m_FramesWritten; f++)
+    {
+        const Frame& frame = m_Frames[f % FrameCapacity];
+        std::fill(stageMs.begin(), stageMs.end(), 0.0);
+        while (next < entries.size() && entries[next].start < frame.start)
+            next++;
+        for (; next < entries.size() && entries[next].start < frame.end; next++)
+            stageMs[entries[next].stage] += TicksToMs(entries[next].duration);
+        const FrameCounters& c = frame.counters;
+        std::fprintf(file, "%llu,%.4f,%.4f", (unsigned long long)f, TicksToMs(frame.start - origin), TicksToMs(frame.end - frame.start));
+        for (double ms : stageMs)
+        {
+            if (frame.start < covered)
+                std::fprintf(file, ",");
+            else
+                std::fprintf(file, ",%.4f", ms);
+        }
+        size_t blank = c.laserPoints - std::min(c.litPoints, c.laserPoints);
+        double ratio = c.laserPoints ? double(c.litPoints) / double(c.laserPoints) : 0.0;
+        std::fprintf(file, ",%zu,%zu,%zu,%.4f,%zu,%zu,%zu,%zu,%zu\n", c.laserPoints, c.litPoints, blank, ratio, c.simSteps,
+            c.lineCalls, c.arcCalls, c.shapeCalls, c.templateCalls);
+    }
+    return std::fclose(file) == 0;
+}
+
+static void WriteJsonString(FILE* file, const char* text)
+{
+    std::fputc('"', file);
+    for (; *text; text++)
+    {
+        if (*text == '"' || *text == '\\')
+            std::fputc('\\', file);
+        std::fputc(*text, file);
+    }
+    std::fputc('"', file);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    uint64_t firstFrame = (m_FramesWritten > FrameCapacity) ? m_FramesWritten - FrameCapacity : 0;
+    uint64_t origin = UINT64_MAX;
+    if (m_FramesWritten > 0)
+        origin = m_Frames[firstFrame % FrameCapacity].start;
+    ForEachEvent([&origin] (int, const Event& event) { origin = std::min(origin, event.start); });
+    auto micros = [this, origin] (uint64_t ticks) { return TicksToMs(ticks - origin) * 1000.0; };
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    auto separator = [&first, file] ()
+    {
+        if (!first)
+            std::fprintf(file, ",\n");
+        first = false;
+    };
+    ForEachEvent([&] (int thread, const Event& event)
+    {
+        separator();
+        std::fprintf(file, "{\"name\":");
+        WriteJsonString(file, event.name);
+        std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            thread, micros(event.start), TicksToMs(event.end - event.start) * 1000.0);
+    });
+    // Frames on their own track, with the counters alongside
+    for (uint64_t f = firstFrame; f < m_FramesWritten; f++)
+    {
+        const Frame& frame = m_Frames[f % FrameCapacity];
+        const FrameCounters& c = frame.counters;
+        separator();
+        std::fprintf(file, "{\"name\":\"Frame %llu\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+            (unsigned long long)f, micros(frame.start), TicksToMs(frame.end - frame.start) * 1000.0);
+        separator();
+        std::fprintf(file, "{\"name\":\"points\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"lit\":%zu,\"blank\":%zu,\"sim steps\":%zu}}",
+            micros(frame.start), c.litPoints, c.laserPoints - std::min(c.litPoints, c.laserPoints), c.simSteps);
+        separator();
+        std::fprintf(file, "{\"name\":\"draw calls\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"lines\":%zu,\"arcs\":%zu,\"shapes\":%zu,\"templates\":%zu}}",
+            micros(frame.start), c.lineCalls, c.arcCalls, c.shapeCalls, c.templateCalls);
+    }
+    separator();
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"frames\"}}\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+void Profiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : m_Threads)
+        buffer->written.store(0, std::memory_order_release);
+    m_FramesWritten = 0;
+}
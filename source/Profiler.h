@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped-timer instrumentation. PROFILE_SCOPE("name") records the enclosing
+// scope's start and end ticks into a fixed ring buffer owned by the calling
+// thread, so recording takes no lock. Disabled at run time a scope costs one
+// relaxed load; building without LASER_PROFILING compiles the scopes out.
+// Scopes belong on per-frame stages: a ring holds EventCapacity events, so
+// per-segment work is counted in FrameCounters instead. Per-frame counters
+// (points, lit points, sim steps, draw calls) are set by the frame loop. Dump with WriteCsv() (one row per frame, time per scope name) or
+// WriteChromeTrace() (chrome://tracing / Perfetto) once the threads being
+// recorded are idle. CSV frames older than the oldest event still held in a
+// ring get empty stage cells.
+// Names must be string literals or otherwise outlive the profiler.
+class Profiler
+{
+public:
+    struct FrameCounters
+    {
+        size_t laserPoints = 0;
+        size_t litPoints = 0;
+        size_t simSteps = 0;
+        size_t lineCalls = 0;
+        size_t arcCalls = 0;
+        size_t shapeCalls = 0;
+        size_t templateCalls = 0;
+        // Fills laserPoints and litPoints from any frame of points with a flags member
+        template <typename Frame>
+        void CountLit(const Frame& frame)
+        {
+            laserPoints = frame.size();
+            litPoints = 0;
+            for (const auto& point : frame)
+                litPoints += point.flags ? 1 : 0;
+        }
+        // Fills the call counts from LaserFrameGenerator::DrawCalls
+        template <typename Calls>
+        void CountDraws(const Calls& calls)
+        {
+            lineCalls = size_t(calls.lines);
+            arcCalls = size_t(calls.arcs);
+            shapeCalls = size_t(calls.shapes);
+            templateCalls = size_t(calls.templates);
+        }
+    };
+    // One stage's time in the last finished frame
+    struct StageTime
+    {
+        const char* name;
+        double ms;
+    };
+    static Profiler& Get();
+    void Enable(bool enabled);
+    bool IsEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+    // Ticks are TSC cycles on x86, steady_clock nanoseconds elsewhere
+    static uint64_t Now();
+    double TicksToMs(uint64_t ticks) const { return double(ticks) * m_MsPerTick; }
+    void Record(const char* name, uint64_t start, uint64_t end);
+    // Frame boundaries on the frame loop's thread; scopes are attributed to the frame they start in
+    void BeginFrame();
+    void EndFrame(const FrameCounters& counters);
+    // Per scope name, the time recorded on any thread during the last finished frame
+    void GetLastFrameStages(std::vector<StageTime>& stages);
+    bool WriteCsv(const std::string& path);
+    bool WriteChromeTrace(const std::string& path);
+    void Clear();
+
+    static constexpr size_t EventCapacity = 1 << 16; // per thread
+    static constexpr size_t FrameCapacity = 1 << 12;
+private:
+    struct Event
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+    struct ThreadBuffer
+    {
+        int thread;
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> written { 0 }; // total ever written; the ring keeps the last EventCapacity
+    };
+    struct Frame
+    {
+        uint64_t start;
+        uint64_t end;
+        FrameCounters counters;
+    };
+    Profiler();
+    ThreadBuffer& LocalBuffer();
+    void Calibrate();
+    // Every recorded event still in the rings, oldest first per thread
+    template <typename Visit>
+    void ForEachEvent(Visit visit);
+    std::vector<const char*> StageNames();
+
+    std::atomic<bool> m_Enabled { false };
+    double m_MsPerTick = 1e-6;
+    std::mutex m_Mutex; // guards m_Threads
+    std::vector<std::unique_ptr<ThreadBuffer>> m_Threads;
+    std::vector<Frame> m_Frames; // ring of FrameCapacity
+    uint64_t m_FramesWritten = 0;
+    uint64_t m_FrameStart = 0;
+};
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char* name) : m_Name(name), m_Start(Profiler::Get().IsEnabled() ? Profiler::Now() : 0) {}
+    ~ScopedTimer()
+    {
+        if (m_Start)
+            Profiler::Get().Record(m_Name, m_Start, Profiler::Now());
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+private:
+    const char* m_Name;
+    uint64_t m_Start;
+};
+
+#ifdef LASER_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -6,6 +6,8 @@
 #include "Point2D.h"
 #include "LaserFrameGenerator.h"
 #include "Matrix3X3.h"
+#include "PointKernel.h"
+#include "PathOptimizer.h"
 
 static float constexpr DEG_TO_RAD = 0.01745329251994f;
 constexpr float PI = 3.14159265358979323846f;
@@ -15,6 +17,10 @@ using LS = LaserFrameGenerator::LaserState;
 using PS = LaserFrameGenerator::PointSharpness;
 using ARC = LaserFrameGenerator::Arc;
 
+// Template scale buckets per doubling; a template is tessellated at its bucket's
+// scale, so segment step counts follow the drawn scale to within about 1%
+static constexpr float TEMPLATE_BUCKETS_PER_OCTAVE = 32.0f;
+
 Linkage::Linkage(LaserFrameGenerator& generator, Point2D c1, float r1, float r2, float linklength, float barlength) :
     m_LaserGen(generator),
     m_c1(c1),
@@ -24,53 +30,116 @@ Linkage::Linkage(LaserFrameGenerator& generator, Point2D c1, float r1, float r2,
     m_barlength(barlength)
 {
     int steps = 360;
-    m_linkagepoints.reserve(steps);
+    // Crank pin positions walk the r1 circle with a fixed rotation step
+    std::vector<float> crankX(steps + 1);
+    std::vector<float> crankY(steps + 1);
+    PointKernel::Arc(Point2D(0.0f, 0.0f), Point2D(m_r1, 0.0f), PI2, steps, steps + 1, crankX.data(), crankY.data());
+    m_linkagepoints.reserve(steps + 1);
     for (int i = 0; i <= steps; i++)
     {
-        float t = (float(i) / float(steps)) * PI2;
-        m_linkagepoints.push_back(calculateL1(t));
+        m_linkagepoints.push_back(calculateL1(Point2D(crankX[i], crankY[i])));
+    }
+    // Rocker angle per crank step, unwrapped so neighbours can be interpolated
+    m_PoseTheta.resize(PoseSteps + 1);
+    for (int i = 0; i <= PoseSteps; i++)
+    {
+        float theta = calculateTheta(PI2 * float(i) / float(PoseSteps));
+        if (i > 0)
+            theta += PI2 * std::round((m_PoseTheta[i - 1] - theta) / PI2);
+        m_PoseTheta[i] = theta;
+    }
+    m_transformedpoints.resize(m_linkagepoints.size());
+}
+
+void ShapeGenerator::LineTo(Point2D next, LS laserstate, PS pointsharpness, LaserColor color)
+{
+    if (m_Optimizer)
+        m_Optimizer->LineTo(next, laserstate, pointsharpness, color);
+    else
+        m_LaserGen.LineTo(next, laserstate, pointsharpness, color);
+}
+
+void ShapeGenerator::ArcTo(Point2D center, Point2D next, LS laserstate, PS pointsharpness, LaserColor color, ARC direction)
+{
+    if (m_Optimizer)
+        m_Optimizer->ArcTo(center, next, laserstate, pointsharpness, color, direction);
+    else
+        m_LaserGen.ArcTo(center, next, laserstate, pointsharpness, color, direction);
+}
+
+void ShapeGenerator::Flush()
+{
+    if (m_Optimizer)
+        m_Optimizer->Flush();
+}
+
+const ShapeTemplate* ShapeGenerator::FindTemplate(TemplateShape shape, const Point2D* outline, int count, const Mat3& matrix, const LaserColor& color)
+{
+    if (!m_UseTemplates || m_Optimizer || !m_LaserGen.CanDrawTemplates())
+        return nullptr;
+    // Only a similarity transform scales every segment alike
+    float sx = std::hypot(matrix.m[0][0], matrix.m[1][0]);
+    float sy = std::hypot(matrix.m[0][1], matrix.m[1][1]);
+    float skew = matrix.m[0][0] * matrix.m[0][1] + matrix.m[1][0] * matrix.m[1][1];
+    if (!(sx > 0.0f) || std::abs(sx - sy) > 1e-4f * sx || std::abs(skew) > 1e-4f * sx * sy)
+        return nullptr;
+    int bucket = int(std::lround(std::log2(sx) * TEMPLATE_BUCKETS_PER_OCTAVE));
+    uint64_t key = (uint64_t(shape) << 32) | uint32_t(bucket);
+    ShapeTemplate& entry = m_Templates[key];
+    if (entry.runs.empty() || !m_LaserGen.IsTemplateCurrent(entry))
+    {
+        // Closed outline of sharp lines, tessellated at the bucket's scale
+        m_LaserGen.BeginTemplate(entry, outline[0], std::exp2(float(bucket) / TEMPLATE_BUCKETS_PER_OCTAVE), color);
+        for (int i = 1; i <= count; i++)
+            m_LaserGen.LineTo(outline[i % count], LS::ON, PS::SHARP, color);
+        m_LaserGen.EndTemplate();
     }
+    return &entry;
 }
 
 void ShapeGenerator::Square(Mat3 matrix, LaserColor color)
 {
-    float x0 = -1.0f;
-    float y0 = -1.0f;
-    float x1 = 1.0f;
-    float y1 = 1.0f;
-    Point2D p0 = matrix.transformPoint(Point2D(x1, y0));
-    Point2D p1 = matrix.transformPoint(Point2D(x1, y1));
-    Point2D p2 = matrix.transformPoint(Point2D(x0, y1));
-    Point2D p3 = matrix.transformPoint(Point2D(x0, y0));
+    static const Point2D outline[] = { { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f }, { -1.0f, -1.0f } };
+    Point2D p0 = matrix.transformPoint(outline[0]);
     //blank to starting point
 	LaserColor debugcolor(180.0f, 180.0f, 0.8f, 0.1f, 0.8f, 0.1f); // dim blue for blanking
-    m_LaserGen.LineTo(p0, LS::OFF, PS::SHARP, debugcolor);
+    LineTo(p0, LS::OFF, PS::SHARP, debugcolor);
+    if (const ShapeTemplate* shape = FindTemplate(TemplateShape::SQUARE, outline, 4, matrix, color))
+    {
+        m_LaserGen.DrawTemplate(*shape, matrix, color);
+        return;
+    }
 	//Laser ON Draw square
-    m_LaserGen.LineTo(p1, LS::ON, PS::SHARP, color);
-    m_LaserGen.LineTo(p2, LS::ON, PS::SHARP, color);
-    m_LaserGen.LineTo(p3, LS::ON, PS::SHARP, color);
-    m_LaserGen.LineTo(p0, LS::ON, PS::SHARP, color);
+    LineTo(matrix.transformPoint(outline[1]), LS::ON, PS::SHARP, color);
+    LineTo(matrix.transformPoint(outline[2]), LS::ON, PS::SHARP, color);
+    LineTo(matrix.transformPoint(outline[3]), LS::ON, PS::SHARP, color);
+    LineTo(p0, LS::ON, PS::SHARP, color);
 }
 
 void ShapeGenerator::Ship(Mat3 matrix, LaserColor color)
 {
-    Point2D shiparray[] = {
+    static const Point2D shiparray[] = {
         { -0.0497f, -0.0344f },
         { -0.0971f, -0.0657f },
         { 0.0972f, 0.0f },
-        { -0.0971f, 0.0657 },
-        { -0.0497f, 0.0329 } };
+        { -0.0971f, 0.0657f },
+        { -0.0497f, 0.0329f } };
     Point2D transformedarray[5];
     for (int i = 0; i < 5; i++)
     {
         transformedarray[i] = matrix.transformPoint(shiparray[i]);
     }
-    m_LaserGen.LineTo(transformedarray[0], LS::OFF, PS::SHARP, color);
+    LineTo(transformedarray[0], LS::OFF, PS::SHARP, color);
+    if (const ShapeTemplate* shape = FindTemplate(TemplateShape::SHIP, shiparray, 5, matrix, color))
+    {
+        m_LaserGen.DrawTemplate(*shape, matrix, color);
+        return;
+    }
     for (int i = 1; i < 5; i++)
     {
-        m_LaserGen.LineTo(transformedarray[i], LS::ON, PS::SHARP, color);
+        LineTo(transformedarray[i], LS::ON, PS::SHARP, color);
     }
-    m_LaserGen.LineTo(transformedarray[0], LS::ON, PS::SHARP, color);
+    LineTo(transformedarray[0], LS::ON, PS::SHARP, color);
 }
 
 void ShapeGenerator::SmoothSquare(Point2D center, float size, LaserColor color)
@@ -81,12 +150,12 @@ void ShapeGenerator::SmoothSquare(Point2D center, float size, LaserColor color)
     float y1 = (center.y + size / 2.0f);
     //blank to starting point
     LaserColor debugcolor(180.0f, 180.0f, 0.8f, 0.1f, 0.8f, 0.1f); // dim blue for blanking
-    m_LaserGen.LineTo(Point2D(x0, y0), LS::OFF, PS::SHARP, debugcolor);
+    LineTo(Point2D(x0, y0), LS::OFF, PS::SHARP, debugcolor);
     //Laser ON Draw square
-    m_LaserGen.LineTo(Point2D(x1, y0), LS::ON, PS::SMOOTH, color);
-    m_LaserGen.LineTo(Point2D(x1, y1), LS::ON, PS::SMOOTH, color);
-    m_LaserGen.LineTo(Point2D(x0, y1), LS::ON, PS::SMOOTH, color);
-    m_LaserGen.LineTo(Point2D(x0, y0), LS::ON, PS::SHARP, color);
+    LineTo(Point2D(x1, y0), LS::ON, PS::SMOOTH, color);
+    LineTo(Point2D(x1, y1), LS::ON, PS::SMOOTH, color);
+    LineTo(Point2D(x0, y1), LS::ON, PS::SMOOTH, color);
+    LineTo(Point2D(x0, y0), LS::ON, PS::SHARP, color);
 }
 
 void ShapeGenerator::ArcTest(Point2D center, float size, LaserColor color)
@@ -97,70 +166,95 @@ void ShapeGenerator::ArcTest(Point2D center, float size, LaserColor color)
     float y1 = (center.y + size / 2.0f);
     //blank to starting point
     LaserColor debugcolor(180.0f, 180.0f, 0.8f, 0.1f, 0.8f, 0.1f); // dim blue for blanking
-    m_LaserGen.LineTo(Point2D(x0, y0), LS::OFF, PS::SHARP, debugcolor);
+    LineTo(Point2D(x0, y0), LS::OFF, PS::SHARP, debugcolor);
     //Laser ON Draw square
-    m_LaserGen.LineTo(Point2D(x1, y0), LS::ON, PS::SHARP, color);
+    LineTo(Point2D(x1, y0), LS::ON, PS::SHARP, color);
 	Point2D centerArc1 = Point2D(x1, y0 + (y1 - y0) / 2.0f);
-    m_LaserGen.ArcTo(centerArc1, Point2D(x1, y1), LS::ON, PS::SHARP, color, LaserFrameGenerator::Arc::CLOCKWISE);
+    ArcTo(centerArc1, Point2D(x1, y1), LS::ON, PS::SHARP, color, LaserFrameGenerator::Arc::CLOCKWISE);
 	Point2D centerArc2 = Point2D(x0 + (x1 - x0) / 2.0f, y1);
-    m_LaserGen.ArcTo(centerArc2, Point2D(x0, y1), LS::ON, PS::SHARP, color, LaserFrameGenerator::Arc::CLOCKWISE);
-    m_LaserGen.LineTo(Point2D(x0, y1), LS::ON, PS::SHARP, color);
-    m_LaserGen.LineTo(Point2D(x0, y0), LS::ON, PS::SHARP, color);
+    ArcTo(centerArc2, Point2D(x0, y1), LS::ON, PS::SHARP, color, LaserFrameGenerator::Arc::CLOCKWISE);
+    LineTo(Point2D(x0, y1), LS::ON, PS::SHARP, color);
+    LineTo(Point2D(x0, y0), LS::ON, PS::SHARP, color);
 }
 
 void Linkage::DrawLinkage(Mat3 matrix, float angle, LaserColor color) const
+{
+    DrawLinkages(&matrix, &angle, 1, color);
+}
+
+void Linkage::DrawLinkages(const Mat3* matrices, const float* angles, int count, LaserColor color) const
 {
     Point2D A1 = Point2D(m_r1, 0.0f);
-    Point2D A2 = Point2D(cosf(angle) * m_r1, sinf(angle) * m_r1);
     Point2D C0 = Point2D(0.0f, 0.0f);
     Point2D C1 = m_c1;
     Point2D B1 = m_c1 + Point2D(m_r2, 0.0f);
-    float theta = calculateTheta(angle);
-    Point2D B2 = C1 + Point2D(cosf(theta) * m_r2, sinf(theta) * m_r2);
-    Point2D L1 = A2 + (B2 - A2).Normalized() * m_barlength;
-
-    Point2D tA1 = matrix.transformPoint(A1);
-    Point2D tA2 = matrix.transformPoint(A2);
-    Point2D tC0 = matrix.transformPoint(C0);
-    Point2D tC1 = matrix.transformPoint(C1);
-    Point2D tB1 = matrix.transformPoint(B1);
-    Point2D tB2 = matrix.transformPoint(B2);
-    Point2D tL1 = matrix.transformPoint(L1);
-
-    m_LaserGen.LineTo(tA1, LS::OFF, PS::SHARP, color);
-    m_LaserGen.ArcTo(tC0, tA2, LS::ON, PS::SHARP, color, ARC::COUNTERCLOCKWISE);
-    m_LaserGen.LineTo(tC0, LS::OFF, PS::SHARP, color);
-    m_LaserGen.LineTo(tA2, LS::ON, PS::SHARP, color);
-    m_LaserGen.LineTo(tB1, LS::OFF, PS::SHARP, color);
-    m_LaserGen.ArcTo(tC1, tB2, LS::ON, PS::SHARP, color, ARC::COUNTERCLOCKWISE);
-    m_LaserGen.LineTo(tC1, LS::OFF, PS::SHARP, color);
-    m_LaserGen.LineTo(tB2, LS::ON, PS::SHARP, color);
-    m_LaserGen.LineTo(tA2, LS::OFF, PS::SHARP, color);
-    m_LaserGen.LineTo(tL1, LS::ON, PS::SHARP, color);
-
-    Point2D p0 = matrix.transformPoint(m_linkagepoints.at(0));
-    m_LaserGen.LineTo(p0, LS::OFF, PS::SHARP, color);
-    std::vector<Point2D> transformedpoints;
-    transformedpoints.reserve(m_linkagepoints.size());
-    for (int i = 0; i < m_linkagepoints.size(); i++)
+    const int size = int(m_linkagepoints.size());
+    for (int n = 0; n < count; n++)
     {
-        transformedpoints.push_back(matrix.transformPoint(m_linkagepoints.at(i)));
+        const Mat3& matrix = matrices[n];
+        const float angle = angles[n];
+        Point2D A2 = Point2D(cosf(angle) * m_r1, sinf(angle) * m_r1);
+        float theta = m_UsePoseTable ? PoseTheta(angle) : calculateTheta(angle);
+        Point2D B2 = C1 + Point2D(cosf(theta) * m_r2, sinf(theta) * m_r2);
+        Point2D L1 = A2 + (B2 - A2).Normalized() * m_barlength;
+
+        Point2D tA1 = matrix.transformPoint(A1);
+        Point2D tA2 = matrix.transformPoint(A2);
+        Point2D tC0 = matrix.transformPoint(C0);
+        Point2D tC1 = matrix.transformPoint(C1);
+        Point2D tB1 = matrix.transformPoint(B1);
+        Point2D tB2 = matrix.transformPoint(B2);
+        Point2D tL1 = matrix.transformPoint(L1);
+
+        m_LaserGen.LineTo(tA1, LS::OFF, PS::SHARP, color);
+        m_LaserGen.ArcTo(tC0, tA2, LS::ON, PS::SHARP, color, ARC::COUNTERCLOCKWISE);
+        m_LaserGen.LineTo(tC0, LS::OFF, PS::SHARP, color);
+        m_LaserGen.LineTo(tA2, LS::ON, PS::SHARP, color);
+        m_LaserGen.LineTo(tB1, LS::OFF, PS::SHARP, color);
+        m_LaserGen.ArcTo(tC1, tB2, LS::ON, PS::SHARP, color, ARC::COUNTERCLOCKWISE);
+        m_LaserGen.LineTo(tC1, LS::OFF, PS::SHARP, color);
+        m_LaserGen.LineTo(tB2, LS::ON, PS::SHARP, color);
+        m_LaserGen.LineTo(tA2, LS::OFF, PS::SHARP, color);
+        m_LaserGen.LineTo(tL1, LS::ON, PS::SHARP, color);
+
+        Point2D p0 = matrix.transformPoint(m_linkagepoints[0]);
+        m_LaserGen.LineTo(p0, LS::OFF, PS::SHARP, color);
+        // DrawShape only emits the first t * size points and ends on the last one, so only those are transformed
+        float lt = (angle + PI2) / PI2;
+        int drawn = std::clamp(static_cast<int>(lt * float(size)), 0, size);
+        for (int i = 0; i < drawn; i++)
+        {
+            m_transformedpoints[i] = matrix.transformPoint(m_linkagepoints[i]);
+        }
+        m_transformedpoints[size - 1] = matrix.transformPoint(m_linkagepoints[size - 1]);
+        m_LaserGen.DrawShape(m_transformedpoints, lt, color);
     }
-    float lt = (angle + PI2) / PI2;
-    m_LaserGen.DrawShape(transformedpoints, lt, color);
 }
 
-Point2D Linkage::calculateL1(float angle) const
+float Linkage::PoseTheta(float angle) const
+{
+    // Crank angle to a fractional table index; the table covers one turn
+    float turns = angle / PI2;
+    float position = (turns - std::floor(turns)) * float(PoseSteps);
+    int index = std::min(static_cast<int>(position), PoseSteps - 1);
+    float fraction = position - float(index);
+    return m_PoseTheta[index] + (m_PoseTheta[index + 1] - m_PoseTheta[index]) * fraction;
+}
+
+Point2D Linkage::calculateL1(Point2D A2) const
 {
-    float theta = calculateTheta(angle);
-    Point2D A2 = Point2D(cosf(angle) * m_r1, sinf(angle) * m_r1);
+    float theta = calculateTheta(A2);
     Point2D B2 = m_c1 + Point2D(cosf(theta) * m_r2, sinf(theta) * m_r2);
     return A2 + (B2 - A2).Normalized() * m_barlength;
 }
 
 float Linkage::calculateTheta(float angle) const
 {
-    Point2D A2 = Point2D(cosf(angle) * m_r1, sinf(angle) * m_r1);
+    return calculateTheta(Point2D(cosf(angle) * m_r1, sinf(angle) * m_r1));
+}
+
+float Linkage::calculateTheta(Point2D A2) const
+{
     Point2D vec = A2 - m_c1;
     float veclength = vec.Length();
     float cosAlpha = (m_r2 * m_r2 + veclength * veclength - m_linklength * m_linklength) / (2.0f * m_r2 * veclength);
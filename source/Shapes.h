@@ -1,20 +1,44 @@
 #pragma once
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 #include "LaserColor.h"
 #include "LaserFrameGenerator.h"
-#include "Matrix3x3.h"
+#include "Matrix3X3.h"
 #include "Point2D.h"
 
+class PathOptimizer;
+
 class ShapeGenerator
 {
 public:
 	ShapeGenerator(LaserFrameGenerator& generator) : m_LaserGen(generator) {}
+	// Record shapes into the optimizer instead of emitting them; nullptr emits directly
+	void SetPathOptimizer(PathOptimizer* optimizer) { m_Optimizer = optimizer; }
+	// Emits everything recorded since the last flush (no-op without an optimizer)
+	void Flush();
 	void Square(Mat3 matrix, LaserColor color);
 	void Ship(Mat3 matrix, LaserColor color);
 	void SmoothSquare(Point2D center, float size, LaserColor color);
 	void ArcTest(Point2D center, float size, LaserColor color);
+	// Square and Ship replay outlines tessellated once per scale bucket (default on).
+	// Off, or with an optimizer, in budget mode or under a non-uniform scale, every segment is drawn.
+	void SetShapeTemplates(bool enabled) { m_UseTemplates = enabled; }
+	size_t GetTemplateCount() const { return m_Templates.size(); }
 private:
+	enum class TemplateShape : uint32_t
+	{
+		SQUARE,
+		SHIP
+	};
+	// The cached template for this outline at the matrix's scale, nullptr when templates do not apply
+	const ShapeTemplate* FindTemplate(TemplateShape shape, const Point2D* outline, int count, const Mat3& matrix, const LaserColor& color);
+	void LineTo(Point2D next, LaserFrameGenerator::LaserState laserstate, LaserFrameGenerator::PointSharpness pointsharpness, LaserColor color);
+	void ArcTo(Point2D center, Point2D next, LaserFrameGenerator::LaserState laserstate, LaserFrameGenerator::PointSharpness pointsharpness, LaserColor color, LaserFrameGenerator::Arc direction);
 	LaserFrameGenerator& m_LaserGen;
+	PathOptimizer* m_Optimizer = nullptr;
+	std::unordered_map<uint64_t, ShapeTemplate> m_Templates; // shape in the high half, scale bucket in the low
+	bool m_UseTemplates = true;
 };
 
 class Linkage
@@ -23,12 +47,24 @@ public:
 	//c1 is the offset of 2nd center from the origin
 	Linkage(LaserFrameGenerator& generator, Point2D c1, float r1, float r2, float linklength, float barlength);
 	void DrawLinkage(Mat3 matrix, float angle, LaserColor color) const;
+	// Draws count copies of the linkage, copy n with matrices[n] at crank angle angles[n]
+	void DrawLinkages(const Mat3* matrices, const float* angles, int count, LaserColor color) const;
+	// Rocker angle from the interpolated pose table (default, within 2e-5 rad) or solved exactly
+	void SetPoseTable(bool enabled) { m_UsePoseTable = enabled; }
 private:
+	// Rocker angle for a crank angle, interpolated from the pose table instead of solved with acos/atan2
+	float PoseTheta(float angle) const;
 	float calculateTheta(float angle) const;
-	Point2D calculateL1(float angle) const;
+	float calculateTheta(Point2D A2) const;
+	Point2D calculateL1(Point2D A2) const;
 	LaserFrameGenerator& m_LaserGen;
 	Point2D m_c1;
 	std::vector<Point2D> m_linkagepoints;
+	static constexpr int PoseSteps = 1440;
+	std::vector<float> m_PoseTheta; // PoseSteps + 1 entries over one crank turn
+	// Scratch for the transformed trace; only the drawn prefix and the last point are written per draw
+	mutable std::vector<Point2D> m_transformedpoints;
+	bool m_UsePoseTable = true;
 	float m_r1;
 	float m_r2;
 	float m_linklength;
@@ -0,0 +1,201 @@
+#include "SoftwareRenderer.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+
+// Below a thousandth of a level after tone mapping
+static constexpr float MinLight = 1e-5f;
+
+// Added before truncating splat positions so truncation floors them. Anything further
+// left of or above the screen lands on pixels that fail the bounds checks anyway.
+static constexpr float SplatOffset = 1024.0f;
+
+// Runs job for every band across the pool, or in order on the calling thread without one
+static void ForEachBand(ThreadPool* pool, size_t bands, const std::function<void(size_t)>& job)
+{
+    if (pool)
+        pool->ParallelFor(bands, job);
+    else
+    {
+        for (size_t i = 0; i < bands; i++)
+            job(i);
+    }
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, ThreadPool* pool) :
+    m_Width(width), m_Height(height), m_Pool(pool)
+{
+    if (width <= 0 || height <= 0)
+        throw std::invalid_argument("SoftwareRenderer size must be positive");
+    // Same aspect-preserving fit as FrameRenderer::SimToScreen
+    float aspect = float(width) / float(height);
+    m_ScaleX = 0.5f * float(width) * (aspect > 1.0f ? 1.0f / aspect : 1.0f);
+    m_ScaleY = 0.5f * float(height) * (aspect > 1.0f ? 1.0f : aspect);
+    m_Accum.assign(size_t(width) * size_t(height) * 3, 0.0f);
+    m_Bands.resize(size_t((height + BandRows - 1) / BandRows));
+    m_BandSamples.resize(m_Bands.size());
+}
+
+void SoftwareRenderer::Clear()
+{
+    std::fill(m_Accum.begin(), m_Accum.end(), 0.0f);
+}
+
+void SoftwareRenderer::DrawFrame(const SimFrame& frame, float elapsed)
+{
+    PROFILE_SCOPE("Rasterize");
+    float decay = m_Persistence > 0.0f ? std::exp(-elapsed / m_Persistence) : 0.0f;
+    BinSegments(frame);
+    ForEachBand(m_Pool, m_Bands.size(), [&] (size_t band) { DrawBand(band, frame, decay); });
+    m_Stats.samples = 0;
+    for (size_t samples : m_BandSamples)
+        m_Stats.samples += samples;
+}
+
+void SoftwareRenderer::BinSegments(const SimFrame& frame)
+{
+    for (std::vector<uint32_t>& band : m_Bands)
+        band.clear();
+    m_Stats.litSegments = 0;
+    float halfWidth = 0.5f * float(m_Width);
+    float halfHeight = 0.5f * float(m_Height);
+    for (size_t i = 0; i + 1 < frame.size(); i++)
+    {
+        const SimPoint& a = frame[i];
+        const SimPoint& b = frame[i + 1];
+        if (!a.flags)
+            continue;
+        float xa = a.x * m_ScaleX + halfWidth;
+        float xb = b.x * m_ScaleX + halfWidth;
+        if (std::max(xa, xb) < -1.0f || std::min(xa, xb) > float(m_Width) + 1.0f)
+            continue;
+        // A splat at y touches rows floor(y - 0.5) and the one below
+        float ya = a.y * m_ScaleY + halfHeight;
+        float yb = b.y * m_ScaleY + halfHeight;
+        int rowMin = int(std::floor(std::min(ya, yb) - 0.5f));
+        int rowMax = int(std::floor(std::max(ya, yb) - 0.5f)) + 1;
+        if (rowMax < 0 || rowMin >= m_Height)
+            continue;
+        int first = std::max(rowMin, 0) / BandRows;
+        int last = std::min(rowMax, m_Height - 1) / BandRows;
+        for (int band = first; band <= last; band++)
+            m_Bands[band].push_back(uint32_t(i));
+        m_Stats.litSegments++;
+    }
+}
+
+void SoftwareRenderer::DrawBand(size_t band, const SimFrame& frame, float decay)
+{
+    int rowBegin = int(band) * BandRows;
+    int rowEnd = std::min(rowBegin + BandRows, m_Height);
+    float* rows = m_Accum.data() + size_t(rowBegin) * size_t(m_Width) * 3;
+    float* rowsEnd = m_Accum.data() + size_t(rowEnd) * size_t(m_Width) * 3;
+    if (decay > 0.0f)
+    {
+        // Light too faint to show is dropped, so decayed values never reach denormals (very slow to multiply)
+        for (float* p = rows; p != rowsEnd; p++)
+        {
+            float v = *p * decay;
+            *p = (v > MinLight) ? v : 0.0f;
+        }
+    }
+    else
+        std::fill(rows, rowsEnd, 0.0f);
+
+    float halfWidth = 0.5f * float(m_Width);
+    float halfHeight = 0.5f * float(m_Height);
+    size_t samples = 0;
+    for (uint32_t index : m_Bands[band])
+    {
+        const SimPoint& a = frame[index];
+        const SimPoint& b = frame[index + 1];
+        float xa = a.x * m_ScaleX + halfWidth;
+        float ya = a.y * m_ScaleY + halfHeight;
+        float dx = b.x * m_ScaleX + halfWidth - xa;
+        float dy = b.y * m_ScaleY + halfHeight - ya;
+        // About one sample per pixel of length, sharing the segment's light
+        int n = std::max(1, int(std::ceil(std::sqrt(dx * dx + dy * dy))));
+        float energy = m_Intensity / (255.0f * float(n));
+        float r = float(a.r) * energy;
+        float g = float(a.g) * energy;
+        float bl = float(a.b) * energy;
+        // Only the samples whose splat reaches this band's rows
+        int kBegin = 0;
+        int kEnd = n;
+        if (std::fabs(dy) > 1e-6f)
+        {
+            float t0 = (float(rowBegin) - 0.5f - ya) / dy;
+            float t1 = (float(rowEnd) + 0.5f - ya) / dy;
+            if (t0 > t1)
+                std::swap(t0, t1);
+            kBegin = std::max(0, int(std::floor(t0 * float(n) - 0.5f)) - 1);
+            kEnd = std::min(n, int(std::ceil(t1 * float(n) - 0.5f)) + 2);
+        }
+        float stepX = dx / float(n);
+        float stepY = dy / float(n);
+        float fx = xa + stepX * (float(kBegin) + 0.5f) - 0.5f + SplatOffset;
+        float fy = ya + stepY * (float(kBegin) + 0.5f) - 0.5f + SplatOffset;
+        for (int k = kBegin; k < kEnd; k++, fx += stepX, fy += stepY)
+        {
+            int x0 = int(fx);
+            int y0 = int(fy);
+            float wx = fx - float(x0);
+            float wy = fy - float(y0);
+            x0 -= int(SplatOffset);
+            y0 -= int(SplatOffset);
+            for (int j = 0; j < 2; j++)
+            {
+                int y = y0 + j;
+                if (y < rowBegin || y >= rowEnd)
+                    continue;
+                float wrow = j ? wy : 1.0f - wy;
+                float* row = m_Accum.data() + size_t(y) * size_t(m_Width) * 3;
+                for (int i = 0; i < 2; i++)
+                {
+                    int x = x0 + i;
+                    if (x < 0 || x >= m_Width)
+                        continue;
+                    float w = wrow * (i ? wx : 1.0f - wx);
+                    float* pixel = row + size_t(x) * 3;
+                    pixel[0] += r * w;
+                    pixel[1] += g * w;
+                    pixel[2] += bl * w;
+                }
+            }
+            samples++;
+        }
+    }
+    m_BandSamples[band] = samples;
+}
+
+void SoftwareRenderer::Resolve(std::vector<uint8_t>& rgb) const
+{
+    rgb.resize(m_Accum.size());
+    size_t bandValues = size_t(BandRows) * size_t(m_Width) * 3;
+    ForEachBand(m_Pool, m_Bands.size(), [&] (size_t band)
+    {
+        size_t begin = band * bandValues;
+        size_t end = std::min(begin + bandValues, m_Accum.size());
+        for (size_t i = begin; i < end; i++)
+        {
+            float v = m_Accum[i];
+            rgb[i] = uint8_t(255.0f * v / (1.0f + v) + 0.5f);
+        }
+    });
+}
+
+void SoftwareRenderer::WritePpm(const std::string& path)
+{
+    Resolve(m_Resolved);
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("Failed to create image " + path);
+    int header = std::fprintf(file, "P6\n%d %d\n255\n", m_Width, m_Height);
+    size_t written = std::fwrite(m_Resolved.data(), 1, m_Resolved.size(), file);
+    if (std::fclose(file) != 0 || header < 0 || written != m_Resolved.size())
+        throw std::runtime_error("Failed to write image " + path);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GalvoSimulator.h"
+
+class ThreadPool;
+
+// CPU back end for viewing SimFrames where Direct2D is not available.
+// Lit segments are drawn additively into a float RGB accumulation buffer,
+// each sampled about once per pixel of length and bilinearly splatted, so
+// lines are anti-aliased and a segment deposits the same light however long
+// it is: slow beams look brighter, as on a real projector. The buffer decays
+// exponentially between frames like phosphor persistence.
+// Rows are cut into bands of BandRows; segments are binned into the bands
+// they touch and the bands are drawn across the pool, each writing only its
+// own rows, so no locking or atomics are needed. Screen mapping matches
+// FrameRenderer.
+class SoftwareRenderer
+{
+public:
+    struct Stats
+    {
+        size_t litSegments = 0;
+        size_t samples = 0;
+    };
+    // pool may be null to draw on the calling thread. Throws std::invalid_argument for an empty size.
+    SoftwareRenderer(int width, int height, ThreadPool* pool = nullptr);
+    // Decay time constant of the accumulated light in seconds; 0 clears every frame
+    void SetPersistence(float seconds) { m_Persistence = seconds; }
+    // Light one lit sim step deposits at full color
+    void SetIntensity(float intensity) { m_Intensity = intensity; }
+    // Decays the buffer by elapsed seconds, then adds the frame's lit segments
+    void DrawFrame(const SimFrame& frame, float elapsed);
+    void Clear();
+    // 8-bit RGB, rows top to bottom, tone mapped with x / (1 + x)
+    void Resolve(std::vector<uint8_t>& rgb) const;
+    // Binary PPM (P6); throws std::runtime_error if the file cannot be written
+    void WritePpm(const std::string& path);
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    const std::vector<float>& GetAccumulation() const { return m_Accum; }
+    const Stats& GetStats() const { return m_Stats; }
+
+    static constexpr int BandRows = 32;
+private:
+    void BinSegments(const SimFrame& frame);
+    void DrawBand(size_t band, const SimFrame& frame, float decay);
+
+    int m_Width;
+    int m_Height;
+    ThreadPool* m_Pool;
+    float m_Persistence = 0.02f;
+    float m_Intensity = 1.0f;
+    float m_ScaleX;
+    float m_ScaleY;
+    std::vector<float> m_Accum; // RGB per pixel
+    std::vector<std::vector<uint32_t>> m_Bands; // lit segment start indices per band, reused every frame
+    std::vector<size_t> m_BandSamples;
+    std::vector<uint8_t> m_Resolved;
+    Stats m_Stats;
+};
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "SpatialHash.h"
+#include "Point2D.h"
+
+SpatialHash::SpatialHash(int cellsPerSide) :
+    m_CellsPerSide(std::max(1, cellsPerSide)),
+    m_CellsPerUnit(float(std::max(1, cellsPerSide)) / 2.0f),
+    m_CellStart(size_t(m_CellsPerSide) * m_CellsPerSide + 1, 0)
+{
+}
+
+int SpatialHash::CellCoord(float v) const
+{
+    // Compare in float first so huge or NaN coordinates cannot overflow the int conversion
+    float c = (v + 1.0f) * m_CellsPerUnit;
+    if (!(c > 0.0f))
+        return 0;
+    if (c >= float(m_CellsPerSide))
+        return m_CellsPerSide - 1;
+    return int(c);
+}
+
+void SpatialHash::Build(const float* x, const float* y, const float* radius, int count, float pad)
+{
+    m_X = x;
+    m_Y = y;
+    m_Radius = radius;
+    m_Stats = Stats {};
+    m_Stats.circles = count;
+    m_Bounds.resize(size_t(count) * 4);
+    std::fill(m_CellStart.begin(), m_CellStart.end(), 0);
+
+    // Count entries per cell (offset by one so the prefix sum yields starts)
+    for (int i = 0; i < count; i++)
+    {
+        float r = radius[i] + pad;
+        int* b = &m_Bounds[size_t(i) * 4];
+        b[0] = CellCoord(x[i] - r);
+        b[1] = CellCoord(y[i] - r);
+        b[2] = CellCoord(x[i] + r);
+        b[3] = CellCoord(y[i] + r);
+        for (int cy = b[1]; cy <= b[3]; cy++)
+        {
+            for (int cx = b[0]; cx <= b[2]; cx++)
+                m_CellStart[cy * m_CellsPerSide + cx + 1]++;
+        }
+    }
+    const int cells = m_CellsPerSide * m_CellsPerSide;
+    for (int c = 0; c < cells; c++)
+        m_CellStart[c + 1] += m_CellStart[c];
+    m_Stats.entries = m_CellStart[cells];
+    m_Entries.resize(m_Stats.entries);
+
+    // Scatter, advancing each cell's start as a cursor, then shift the starts back
+    for (int i = 0; i < count; i++)
+    {
+        const int* b = &m_Bounds[size_t(i) * 4];
+        for (int cy = b[1]; cy <= b[3]; cy++)
+        {
+            for (int cx = b[0]; cx <= b[2]; cx++)
+                m_Entries[m_CellStart[cy * m_CellsPerSide + cx]++] = i;
+        }
+    }
+    for (int c = cells; c > 0; c--)
+        m_CellStart[c] = m_CellStart[c - 1];
+    m_CellStart[0] = 0;
+
+    if (m_Stamp.size() < size_t(count))
+        m_Stamp.resize(count, 0);
+}
+
+void SpatialHash::Query(Point2D center, float radius, std::vector<int>& out)
+{
+    if (++m_QueryStamp == 0)
+    {
+        // Wrapped: clear the stamps so no circle looks already reported
+        std::fill(m_Stamp.begin(), m_Stamp.end(), 0);
+        m_QueryStamp = 1;
+    }
+    int x0 = CellCoord(center.x - radius);
+    int y0 = CellCoord(center.y - radius);
+    int x1 = CellCoord(center.x + radius);
+    int y1 = CellCoord(center.y + radius);
+    for (int cy = y0; cy <= y1; cy++)
+    {
+        for (int cx = x0; cx <= x1; cx++)
+        {
+            int cell = cy * m_CellsPerSide + cx;
+            for (int e = m_CellStart[cell]; e < m_CellStart[cell + 1]; e++)
+            {
+                int c = m_Entries[e];
+                if (m_Stamp[c] == m_QueryStamp)
+                    continue;
+                float dx = center.x - m_X[c];
+                float dy = center.y - m_Y[c];
+                float r = m_Radius[c] + radius;
+                if (dx * dx + dy * dy <= r * r)
+                {
+                    m_Stamp[c] = m_QueryStamp;
+                    out.push_back(c);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Point2D.h"
+
+// Uniform grid over the normalized [-1,1] play field. Circles are binned into
+// every cell their bounds touch; anything outside the field lands in the edge
+// cells. Build() re-bins from structure-of-arrays input each frame with a
+// counting sort into storage kept between frames, so a steady-state frame
+// does not allocate.
+class SpatialHash
+{
+public:
+    struct Hit
+    {
+        int point;  // index into the FindHits input
+        int circle; // index into the Build input
+    };
+    struct Stats
+    {
+        int circles = 0;
+        int entries = 0;    // circle/cell entries, > circles when circles straddle cells
+        int candidates = 0; // distance tests made by the last FindHits
+        int hits = 0;
+    };
+    explicit SpatialHash(int cellsPerSide = 32);
+    // The arrays must stay valid until the next Build. Bounds are padded by pad
+    // so FindHits sees every circle within pointRadius <= pad of a point.
+    void Build(const float* x, const float* y, const float* radius, int count, float pad = 0.0f);
+    // Appends every circle overlapping the given circle to out, each once
+    void Query(Point2D center, float radius, std::vector<int>& out);
+    // Batched point query. Each circle within pointRadius of a point is offered to
+    // accept(circle) in turn; the first it takes (and may apply damage to) is recorded
+    // as that point's hit. Points that hit nothing are left out of hits.
+    template <typename Accept>
+    void FindHits(const float* x, const float* y, int count, float pointRadius, Accept accept, std::vector<Hit>& hits);
+    const Stats& GetStats() const { return m_Stats; }
+    int GetCellsPerSide() const { return m_CellsPerSide; }
+private:
+    int CellCoord(float v) const;
+    int m_CellsPerSide;
+    float m_CellsPerUnit;
+    std::vector<int> m_CellStart;   // m_Entries range of cell c is [m_CellStart[c], m_CellStart[c + 1])
+    std::vector<int> m_Entries;     // circle indices grouped by cell
+    std::vector<int> m_Bounds;      // per circle: x0, y0, x1, y1 in cells
+    std::vector<uint32_t> m_Stamp;  // per circle: last Query that reported it
+    uint32_t m_QueryStamp = 0;
+    const float* m_X = nullptr;
+    const float* m_Y = nullptr;
+    const float* m_Radius = nullptr;
+    Stats m_Stats;
+};
+
+template <typename Accept>
+void SpatialHash::FindHits(const float* x, const float* y, int count, float pointRadius, Accept accept, std::vector<Hit>& hits)
+{
+    m_Stats.candidates = 0;
+    m_Stats.hits = 0;
+    for (int i = 0; i < count; i++)
+    {
+        // Circles are binned by their padded bounds, so the point's own cell holds every candidate
+        int cell = CellCoord(y[i]) * m_CellsPerSide + CellCoord(x[i]);
+        for (int e = m_CellStart[cell]; e < m_CellStart[cell + 1]; e++)
+        {
+            int c = m_Entries[e];
+            float dx = x[i] - m_X[c];
+            float dy = y[i] - m_Y[c];
+            float r = m_Radius[c] + pointRadius;
+            m_Stats.candidates++;
+            if (dx * dx + dy * dy <= r * r && accept(c))
+            {
+                hits.push_back(Hit { i, c });
+                m_Stats.hits++;
+                break;
+            }
+        }
+    }
+}
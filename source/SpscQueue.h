@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded single-producer single-consumer ring. TryPush/TryPop never block or
+// lock; Push/Pop block with C++20 atomic waits, which stay in user space
+// while the other side keeps up. Exactly one thread may push and one may pop.
+template <typename T>
+class SpscQueue
+{
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        m_Slots.resize(size);
+        m_Mask = uint32_t(size - 1);
+    }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t Capacity() const { return m_Slots.size(); }
+    // Entries queued; exact on either end's own thread, a snapshot anywhere else
+    size_t Size() const
+    {
+        // Head first: it never passes the tail, so a later tail load cannot come out below it
+        uint32_t head = m_Head.load(std::memory_order_acquire);
+        return m_Tail.load(std::memory_order_acquire) - head;
+    }
+
+    bool TryPush(const T& value)
+    {
+        uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail - m_Head.load(std::memory_order_acquire) == m_Slots.size())
+            return false;
+        Publish(tail, value);
+        return true;
+    }
+
+    bool TryPop(T& value)
+    {
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        if (m_Tail.load(std::memory_order_acquire) == head)
+            return false;
+        Consume(head, value);
+        return true;
+    }
+
+    // Pushes all count values with one publish, or none if they do not all fit
+    bool TryPushMany(const T* values, size_t count)
+    {
+        uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (m_Slots.size() - (tail - m_Head.load(std::memory_order_acquire)) < count)
+            return false;
+        for (size_t i = 0; i < count; i++)
+            m_Slots[(tail + uint32_t(i)) & m_Mask] = values[i];
+        m_Tail.store(tail + uint32_t(count), std::memory_order_release);
+        m_Tail.notify_one();
+        return true;
+    }
+
+    // Pops up to count values with one release, returns how many
+    size_t TryPopMany(T* values, size_t count)
+    {
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        size_t available = m_Tail.load(std::memory_order_acquire) - head;
+        if (count > available)
+            count = available;
+        for (size_t i = 0; i < count; i++)
+            values[i] = m_Slots[(head + uint32_t(i)) & m_Mask];
+        if (count)
+        {
+            m_Head.store(head + uint32_t(count), std::memory_order_release);
+            m_Head.notify_one();
+        }
+        return count;
+    }
+
+    void Push(const T& value)
+    {
+        uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        uint32_t head;
+        while (tail - (head = m_Head.load(std::memory_order_acquire)) == m_Slots.size())
+            m_Head.wait(head, std::memory_order_acquire);
+        Publish(tail, value);
+    }
+
+    T Pop()
+    {
+        uint32_t head = m_Head.load(std::memory_order_relaxed);
+        uint32_t tail;
+        while ((tail = m_Tail.load(std::memory_order_acquire)) == head)
+            m_Tail.wait(tail, std::memory_order_acquire);
+        T value;
+        Consume(head, value);
+        return value;
+    }
+
+private:
+    void Publish(uint32_t tail, const T& value)
+    {
+        m_Slots[tail & m_Mask] = value;
+        m_Tail.store(tail + 1, std::memory_order_release);
+        m_Tail.notify_one();
+    }
+
+    void Consume(uint32_t head, T& value)
+    {
+        value = m_Slots[head & m_Mask];
+        m_Head.store(head + 1, std::memory_order_release);
+        m_Head.notify_one();
+    }
+
+    std::vector<T> m_Slots;
+    uint32_t m_Mask;
+    // Free-running indices on separate cache lines; tail - head is the fill level
+    alignas(64) std::atomic<uint32_t> m_Head { 0 }; // written by the consumer
+    alignas(64) std::atomic<uint32_t> m_Tail { 0 }; // written by the producer
+};
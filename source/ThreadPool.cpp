@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    // The calling thread works too, so spawn one fewer
+    unsigned workers = std::max(threadCount, 1u) - 1;
+    m_Workers.reserve(workers);
+    for (unsigned i = 0; i < workers; i++)
+    {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkReady.notify_all();
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& job)
+{
+    if (count == 0)
+        return;
+    if (m_Workers.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Job = &job;
+        m_JobCount = count;
+        m_NextIndex.store(0, std::memory_order_relaxed);
+        m_ActiveWorkers = unsigned(m_Workers.size());
+        m_Generation++;
+    }
+    m_WorkReady.notify_all();
+    RunJobs();
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_WorkDone.wait(lock, [this] () { return m_ActiveWorkers == 0; });
+    m_Job = nullptr;
+}
+
+void ThreadPool::RunJobs()
+{
+    const std::function<void(size_t)>& job = *m_Job;
+    for (size_t i = m_NextIndex.fetch_add(1); i < m_JobCount; i = m_NextIndex.fetch_add(1))
+    {
+        job(i);
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    unsigned seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkReady.wait(lock, [&] () { return m_Stop || m_Generation != seenGeneration; });
+            if (m_Stop)
+                return;
+            seenGeneration = m_Generation;
+        }
+        RunJobs();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--m_ActiveWorkers == 0)
+                m_WorkDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for fork/join style work.
+// ParallelFor hands out indices from a shared counter, the calling thread
+// helps out, and the call returns once every index has been processed.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    // Number of threads taking part in ParallelFor, including the caller
+    unsigned GetThreadCount() const { return unsigned(m_Workers.size()) + 1; }
+    void ParallelFor(size_t count, const std::function<void(size_t)>& job);
+private:
+    void WorkerLoop();
+    void RunJobs();
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkReady;
+    std::condition_variable m_WorkDone;
+    const std::function<void(size_t)>* m_Job = nullptr;
+    size_t m_JobCount = 0;
+    std::atomic<size_t> m_NextIndex { 0 };
+    unsigned m_ActiveWorkers = 0;
+    unsigned m_Generation = 0;
+    bool m_Stop = false;
+};